@@ -1,20 +1,26 @@
 #ifndef _YFAST_FASTMAP_H
 #define _YFAST_FASTMAP_H
 
+#include <algorithm>
 #include <functional>
 #include <initializer_list>
 #include <iterator>
 #include <memory>
+#include <span>
 #include <stdexcept>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include <yfast/impl/yfast.h>
+#include <yfast/internal/bucket.h>
 #include <yfast/internal/concepts.h>
 #include <yfast/internal/default_hash.h>
 #include <yfast/internal/fastmap.h>
+#include <yfast/internal/thresholds.h>
 #include <yfast/internal/bit_extractor.h>
 #include <yfast/utils/maybe_const.h>
+#include <yfast/utils/slab.h>
 
 namespace yfast {
 
@@ -24,18 +30,26 @@ namespace yfast {
  * @tparam Value value type
  * @tparam H key length in bits
  * @tparam BitExtractor helper type to provide key shifts and bit extractions
- * @tparam Hash map from shifted keys to \a std::uintptr_t
- * @tparam Compare key comparator
+ * @tparam Hash map from shifted keys to \a std::uintptr_t (one per level) or level storage policy such as
+ * \a yfast::internal::UnifiedLevels
+ * @tparam Compare key comparator; if transparent (e.g. \a std::less<>), lookups by key types that both \a Compare
+ * and \a BitExtractor take (e.g. \a std::string_view for \a std::string keys) construct no \a Key
  * @tparam ArbitraryAllocator allocator
+ * @tparam Buckets bucket policy: \a yfast::internal::AVLBuckets, \a yfast::internal::CompactAVLBuckets or
+ * \a yfast::internal::SortedArrayBuckets, optionally wrapped into \a yfast::internal::MinimumRepresentatives
+ * @tparam Thresholds bucket split/merge threshold policy: \a yfast::internal::DefaultThresholds,
+ * \a yfast::internal::FixedThresholds or \a yfast::internal::AdaptiveThresholds
  */
 template <
     typename Key,
     typename Value,
     unsigned int H,
     internal::BitExtractorGeneric<Key> BitExtractor = internal::BitExtractor<Key>,
-    internal::MapGeneric<typename BitExtractor::ShiftResult, std::uintptr_t> Hash = internal::DefaultHash<typename BitExtractor::ShiftResult, std::uintptr_t>,
+    internal::LevelHashGeneric<typename BitExtractor::ShiftResult> Hash = internal::DefaultHash<typename BitExtractor::ShiftResult, std::uintptr_t>,
     typename Compare = std::less<Key>,
-    typename ArbitraryAllocator = std::allocator<Key>
+    typename ArbitraryAllocator = std::allocator<Key>,
+    internal::BucketPolicyGeneric<internal::YFastLeaf<Key, Value>, Compare> Buckets = internal::AVLBuckets,
+    internal::ThresholdPolicyGeneric<H> Thresholds = internal::DefaultThresholds
 >
 class fastmap {
 public:
@@ -55,11 +69,22 @@ public:
     static constexpr unsigned int KeyLength = H;
 
 private:
-    typedef internal::YFastLeaf<Key, Value> YFastLeaf;
+    typedef typename internal::BucketLeaf<Buckets, Key, Value>::Type YFastLeaf;
 
-    typedef typename std::allocator_traits<ArbitraryAllocator>::template rebind_alloc<YFastLeaf> Alloc;
+    typedef typename internal::LeafAllocator<YFastLeaf, ArbitraryAllocator>::Type Alloc;
 
-    typedef impl::YFastTrie<YFastLeaf, H, BitExtractor, Hash, Compare, ArbitraryAllocator> YFastTrie;
+    /**
+     * whether \a ArbitraryAllocator is an arena, which the x-fast trie leaves always come from and which is released
+     * all at once by \a clear()
+     */
+    static constexpr bool ARENA = internal::ArenaAllocatorGeneric<typename std::allocator_traits<ArbitraryAllocator>::template rebind_alloc<YFastLeaf>>;
+
+    /**
+     * whether entries come from that arena as well, rather than from their own allocator (e.g. a node pool)
+     */
+    static constexpr bool LEAF_ARENA = internal::ArenaAllocatorGeneric<Alloc>;
+
+    typedef impl::YFastTrie<YFastLeaf, H, BitExtractor, Hash, Compare, ArbitraryAllocator, Buckets, Thresholds> YFastTrie;
 
     template <bool Const>
     class IteratorBase: private YFastTrie::Where {
@@ -90,19 +115,15 @@ private:
         }
 
         void forward() {
-            auto succ = YFastTrie::Value::succ(leaf);
+            auto succ = bucket_succ();
             if (succ != nullptr) {
                 leaf = succ;
             }
             else {
-                if (trie->rebuilds() > _last_rebuild) {
-                    auto where = trie->find(leaf->key);
-                    xleaf = where.xleaf;
-                    _last_rebuild = trie->rebuilds();
-                }
+                sync();
                 xleaf = xleaf->nxt;
                 if (xleaf != nullptr) {
-                    leaf = xleaf->value.leftmost();
+                    leaf = xleaf->min;
                 }
                 else {
                     leaf = nullptr;
@@ -111,19 +132,15 @@ private:
         }
 
         void backward() {
-            auto pred = YFastTrie::Value::pred(leaf);
+            auto pred = bucket_pred();
             if (pred != nullptr) {
                 leaf = pred;
             }
             else {
-                if (trie->rebuilds() > _last_rebuild) {
-                    auto where = trie->find(leaf->key);
-                    xleaf = where.xleaf;
-                    _last_rebuild = trie->rebuilds();
-                }
+                sync();
                 xleaf = xleaf->prv;
                 if (xleaf != nullptr) {
-                    leaf = xleaf->value.rightmost();
+                    leaf = xleaf->max;
                 }
                 else {
                     leaf = nullptr;
@@ -131,6 +148,36 @@ private:
             }
         }
 
+        // find the bucket anew if the one held may have been rebuilt
+        void sync() {
+            if (trie->rebuilds() > _last_rebuild) {
+                auto where = trie->find(leaf->key);
+                xleaf = where.xleaf;
+                _last_rebuild = trie->rebuilds();
+            }
+        }
+
+        // linked buckets step from a leaf directly, the others search the bucket for it
+        YFastLeaf* bucket_succ() {
+            if constexpr (requires { YFastTrie::Value::succ(leaf); }) {
+                return YFastTrie::Value::succ(leaf);
+            }
+            else {
+                sync();
+                return xleaf->value.succ(leaf);
+            }
+        }
+
+        YFastLeaf* bucket_pred() {
+            if constexpr (requires { YFastTrie::Value::pred(leaf); }) {
+                return YFastTrie::Value::pred(leaf);
+            }
+            else {
+                sync();
+                return xleaf->value.pred(leaf);
+            }
+        }
+
     public:
         key_type& key() const {
             if (leaf == nullptr) {
@@ -421,6 +468,102 @@ public:
         }
     };
 
+private:
+    template <bool Const>
+    class CursorBase {
+        friend class fastmap;
+
+        typedef typename utils::MaybeConst<fastmap, Const>::Type Map;
+        typedef std::conditional_t<Const, const_iterator, iterator> Iterator;
+
+        Map* _map;
+        typename YFastTrie::Where _where;
+        unsigned int _last_rebuild;
+
+        explicit CursorBase(Map* map): _map(map), _where(map->_trie.nowhere), _last_rebuild(map->_trie.rebuilds()) {}
+
+        const typename YFastTrie::Where& hint() {
+            if (_map->_trie.rebuilds() != _last_rebuild) {
+                _where = _map->_trie.nowhere;
+                _last_rebuild = _map->_trie.rebuilds();
+            }
+            return _where;
+        }
+
+        Iterator remember(const typename YFastTrie::Where& where) {
+            if (where.xleaf != nullptr) {
+                _where = where;
+            }
+            return Iterator(where);
+        }
+
+    public:
+        /**
+         * find an entry by key
+         * @param key key to find
+         * @return iterator pointing to the entry with the key equal to \a key if any or \a end() otherwise
+         */
+        template <typename K = Key>
+        Iterator find(const K& key) {
+            return remember(_map->_trie.find_near(_map->lookup_key(key), hint()));
+        }
+
+        /**
+         * find a predecessor entry for a key
+         * @param key key
+         * @param strict whether an entry with the key strictly less than \a key should be returned
+         * @return iterator pointing to the entry with the maximal key either not greater or strictly less than \a key
+         */
+        template <typename K = Key>
+        Iterator pred(const K& key, bool strict = false) {
+            return remember(_map->_trie.pred_near(_map->lookup_key(key), hint(), strict));
+        }
+
+        /**
+         * find a successor entry for a key
+         * @param key key
+         * @param strict whether an entry with the key strictly greater than \a key should be returned
+         * @return iterator pointing to the entry with the minimal key either not less or strictly greater than \a key
+         */
+        template <typename K = Key>
+        Iterator succ(const K& key, bool strict = false) {
+            return remember(_map->_trie.succ_near(_map->lookup_key(key), hint(), strict));
+        }
+
+        /**
+         * find a successor entry for a key
+         * @param key key
+         * @return iterator pointing to the entry with the minimal key not less than \a key
+         */
+        template <typename K = Key>
+        Iterator lower_bound(const K& key) {
+            return succ(key);
+        }
+
+        /**
+         * find a successor entry for a key
+         * @param key key
+         * @return iterator pointing to the entry with the minimal key strictly greater than \a key
+         */
+        template <typename K = Key>
+        Iterator upper_bound(const K& key) {
+            return succ(key, true);
+        }
+    };
+
+public:
+    /**
+     * finger for nearly sorted queries: remembers the bucket of the previous result and checks it and its neighbors
+     * first, falling back to a full lookup only if the key is farther away; remains valid as long as the container
+     * does, insertions and erasures merely drop the remembered bucket when needed
+     */
+    typedef CursorBase<false> cursor;
+
+    /**
+     * const finger for nearly sorted queries (see \a cursor)
+     */
+    typedef CursorBase<true> const_cursor;
+
 private:
     Alloc _alloc;
     YFastTrie _trie;
@@ -447,6 +590,25 @@ public:
      */
     [[nodiscard]] bool empty() const { return _trie.size() == 0; }
 
+    /**
+     * @return the number of entries above which a bucket is split (as currently tuned by \a Thresholds)
+     */
+    [[nodiscard]] unsigned int split_threshold() const { return _trie.split_threshold(); }
+
+    /**
+     * @return cursor with no remembered position
+     */
+    cursor make_cursor() {
+        return cursor(this);
+    }
+
+    /**
+     * @return const cursor with no remembered position
+     */
+    const_cursor make_cursor() const {
+        return const_cursor(this);
+    }
+
     /**
      * @return mutable forward iterator pointing at the leftmost entry
      */
@@ -536,8 +698,9 @@ public:
      * @param key key to find
      * @return iterator pointing to the entry with the key equal to \a key if any or \a end() otherwise
      */
-    iterator find(const Key& key) {
-        auto where = _trie.find(key);
+    template <typename K = Key>
+    iterator find(const K& key) {
+        auto where = _trie.find(lookup_key(key));
         return iterator(where);
     }
 
@@ -546,8 +709,9 @@ public:
      * @param key key to find
      * @return const iterator pointing to the entry with the key equal to \a key if any or \a end() otherwise
      */
-    const_iterator find(const Key& key) const {
-        auto where = _trie.find(key);
+    template <typename K = Key>
+    const_iterator find(const K& key) const {
+        auto where = _trie.find(lookup_key(key));
         return const_iterator(where);
     }
 
@@ -557,8 +721,9 @@ public:
      * @param strict whether an entry with the key strictly less than \a key should be returned
      * @return iterator pointing to the entry with the maximal key either not greater or strictly less than \a key
      */
-    iterator pred(const Key& key, bool strict = false) {
-        auto where = _trie.pred(key, strict);
+    template <typename K = Key>
+    iterator pred(const K& key, bool strict = false) {
+        auto where = _trie.pred(lookup_key(key), strict);
         return iterator(where);
     }
 
@@ -568,8 +733,9 @@ public:
      * @param strict whether an entry with the key strictly less than \a key should be returned
      * @return const iterator pointing to the entry with the maximal key either not greater or strictly less than \a key
      */
-    const_iterator pred(const Key& key, bool strict = false) const {
-        auto where = _trie.pred(key, strict);
+    template <typename K = Key>
+    const_iterator pred(const K& key, bool strict = false) const {
+        auto where = _trie.pred(lookup_key(key), strict);
         return const_iterator(where);
     }
 
@@ -579,8 +745,9 @@ public:
      * @param strict whether an entry with the key strictly greater than \a key should be returned
      * @return iterator pointing to the entry with the minimal key either not less or strictly greater than \a key
      */
-    iterator succ(const Key& key, bool strict = false) {
-        auto where = _trie.succ(key, strict);
+    template <typename K = Key>
+    iterator succ(const K& key, bool strict = false) {
+        auto where = _trie.succ(lookup_key(key), strict);
         return iterator(where);
     }
 
@@ -590,17 +757,87 @@ public:
      * @param strict whether an entry with the key strictly greater than \a key should be returned
      * @return const iterator pointing to the entry with the minimal key either not less or strictly greater than \a key
      */
-    const_iterator succ(const Key& key, bool strict = false) const {
-        auto where = _trie.succ(key, strict);
+    template <typename K = Key>
+    const_iterator succ(const K& key, bool strict = false) const {
+        auto where = _trie.succ(lookup_key(key), strict);
         return const_iterator(where);
     }
 
+    /**
+     * find entries for a batch of keys; lookups of different keys are interleaved so that their cache misses overlap
+     * @param keys keys to find
+     * @param found output: iterators pointing to the entries with the keys equal to \a keys or \a end() (same size as
+     * \a keys)
+     */
+    void find_batch(std::span<const Key> keys, std::span<iterator> found) {
+        batch(keys, found, [this] (auto keys, auto wheres) { _trie.find_batch(keys, wheres); });
+    }
+
+    /**
+     * find entries for a batch of keys; lookups of different keys are interleaved so that their cache misses overlap
+     * @param keys keys to find
+     * @param found output: const iterators pointing to the entries with the keys equal to \a keys or \a end() (same
+     * size as \a keys)
+     */
+    void find_batch(std::span<const Key> keys, std::span<const_iterator> found) const {
+        batch(keys, found, [this] (auto keys, auto wheres) { _trie.find_batch(keys, wheres); });
+    }
+
+    /**
+     * find predecessor entries for a batch of keys; lookups of different keys are interleaved so that their cache
+     * misses overlap
+     * @param keys keys
+     * @param found output: iterators pointing to the entries with the maximal keys either not greater or strictly less
+     * than \a keys (same size as \a keys)
+     * @param strict whether entries with keys strictly less than \a keys should be returned
+     */
+    void pred_batch(std::span<const Key> keys, std::span<iterator> found, bool strict = false) {
+        batch(keys, found, [this, strict] (auto keys, auto wheres) { _trie.pred_batch(keys, wheres, strict); });
+    }
+
+    /**
+     * find predecessor entries for a batch of keys; lookups of different keys are interleaved so that their cache
+     * misses overlap
+     * @param keys keys
+     * @param found output: const iterators pointing to the entries with the maximal keys either not greater or
+     * strictly less than \a keys (same size as \a keys)
+     * @param strict whether entries with keys strictly less than \a keys should be returned
+     */
+    void pred_batch(std::span<const Key> keys, std::span<const_iterator> found, bool strict = false) const {
+        batch(keys, found, [this, strict] (auto keys, auto wheres) { _trie.pred_batch(keys, wheres, strict); });
+    }
+
+    /**
+     * find successor entries for a batch of keys; lookups of different keys are interleaved so that their cache misses
+     * overlap
+     * @param keys keys
+     * @param found output: iterators pointing to the entries with the minimal keys either not less or strictly greater
+     * than \a keys (same size as \a keys)
+     * @param strict whether entries with keys strictly greater than \a keys should be returned
+     */
+    void succ_batch(std::span<const Key> keys, std::span<iterator> found, bool strict = false) {
+        batch(keys, found, [this, strict] (auto keys, auto wheres) { _trie.succ_batch(keys, wheres, strict); });
+    }
+
+    /**
+     * find successor entries for a batch of keys; lookups of different keys are interleaved so that their cache misses
+     * overlap
+     * @param keys keys
+     * @param found output: const iterators pointing to the entries with the minimal keys either not less or strictly
+     * greater than \a keys (same size as \a keys)
+     * @param strict whether entries with keys strictly greater than \a keys should be returned
+     */
+    void succ_batch(std::span<const Key> keys, std::span<const_iterator> found, bool strict = false) const {
+        batch(keys, found, [this, strict] (auto keys, auto wheres) { _trie.succ_batch(keys, wheres, strict); });
+    }
+
     /**
      * find a successor entry for a key
      * @param key key
      * @return iterator pointing to the entry with the minimal key not less than \a key
      */
-    iterator lower_bound(const Key& key) {
+    template <typename K = Key>
+    iterator lower_bound(const K& key) {
         return succ(key);
     }
 
@@ -609,7 +846,8 @@ public:
      * @param key key
      * @return const iterator pointing to the entry with the minimal key not less than \a key
      */
-    const_iterator lower_bound(const Key& key) const {
+    template <typename K = Key>
+    const_iterator lower_bound(const K& key) const {
         return succ(key);
     }
 
@@ -618,7 +856,8 @@ public:
      * @param key key
      * @return iterator pointing to the entry with the minimal key strictly greater than \a key
      */
-    iterator upper_bound(const Key& key) {
+    template <typename K = Key>
+    iterator upper_bound(const K& key) {
         return succ(key, true);
     }
 
@@ -627,7 +866,8 @@ public:
      * @param key key
      * @return const iterator pointing to the entry with the minimal key strictly greater than \a key
      */
-    const_iterator upper_bound(const Key& key) const {
+    template <typename K = Key>
+    const_iterator upper_bound(const K& key) const {
         return succ(key, true);
     }
 
@@ -680,6 +920,71 @@ public:
         return iterator(where);
     }
 
+    /**
+     * replace the contents with the entries of a range sorted by key in linear time: instead of separate inserts, the
+     * range is cut into buckets built balanced at once as it goes, and the level tables are reserved up front if the
+     * range can be measured; of several entries with equal keys the last one is kept, as if inserted one by one
+     * @param first beginning of the range of keys (or key-value pairs) in ascending key order
+     * @param last end of the range
+     * @throw std::invalid_argument if the range is not sorted; the container is left empty, as on any other exception
+     */
+    template <typename InputIt>
+    void assign_sorted(InputIt first, InputIt last) {
+        clear();
+        if constexpr (std::forward_iterator<InputIt>) {
+            _trie.reserve(std::distance(first, last));
+        }
+        const auto& cmp = _trie.compare();
+        const auto target = _trie.append_size();
+        // leaves not appended yet: a bucket is cut once twice as many are pending, so that none gets too small
+        std::vector<YFastLeaf*> pending;
+        try {
+            pending.reserve(2 * target);
+            for (; first != last; ++first) {
+                YFastLeaf* leaf = std::allocator_traits<Alloc>::allocate(_alloc, 1);
+                try {
+                    if constexpr (std::is_void_v<Value>) {
+                        std::allocator_traits<Alloc>::construct(_alloc, leaf, *first);
+                    }
+                    else {
+                        const auto& entry = *first;
+                        std::allocator_traits<Alloc>::construct(_alloc, leaf, entry.first, entry.second);
+                    }
+                }
+                catch (...) {
+                    std::allocator_traits<Alloc>::deallocate(_alloc, leaf, 1);
+                    throw;
+                }
+                if (!pending.empty() && !cmp(pending.back()->key, leaf->key)) {
+                    if (cmp(leaf->key, pending.back()->key)) {
+                        dispose(leaf);
+                        throw std::invalid_argument("yfast::fastmap::assign_sorted");
+                    }
+                    dispose(pending.back());
+                    pending.back() = leaf;
+                    continue;
+                }
+                pending.push_back(leaf);
+                if (pending.size() == 2 * target) {
+                    _trie.append(std::span<YFastLeaf* const>(pending.data(), target));
+                    pending.erase(pending.begin(), pending.begin() + target);
+                }
+            }
+            // the rest makes one bucket, or two if more than a full one
+            const auto half = pending.size() > target ? pending.size() / 2 : pending.size();
+            _trie.append(std::span<YFastLeaf* const>(pending.data(), half));
+            pending.erase(pending.begin(), pending.begin() + half);
+            _trie.append(pending);
+        }
+        catch (...) {
+            for (auto leaf: pending) {
+                dispose(leaf);
+            }
+            clear();
+            throw;
+        }
+    }
+
     /**
      * erase entry by iterator
      * @param i iterator (may be a const iterator and/or a reverse iterator)
@@ -705,7 +1010,8 @@ public:
      * @param key key to find and erase
      * @return \a true if the entry has been found and erased or \a false otherwise
      */
-    bool erase(const Key& key) {
+    template <typename K = Key, typename = std::enable_if_t<!std::is_base_of_v<typename YFastTrie::Where, K>>>
+    bool erase(const K& key) {
         auto i = find(key);
         if (i == end()) {
             return false;
@@ -717,23 +1023,81 @@ public:
     }
 
     /**
-     * erase all entries
+     * allocate room in the level tables (if supported by \a Hash) to avoid rehashing while growing
+     * @param n expected number of entries
+     */
+    void reserve(std::size_t n) { _trie.reserve(n); }
+
+    /**
+     * erase all entries; with an arena allocator (see \a yfast::utils::ArenaAllocator) entries are released all at
+     * once, without even being visited if trivially destructible
      */
     void clear() {
-        typename YFastTrie::XFastLeaf* xleaf = _trie.leftmost().xleaf;
-        while (xleaf != nullptr) {
-            destroy_subtree(xleaf->value.root());
-            xleaf = xleaf->nxt;
+        if constexpr (!LEAF_ARENA || !std::is_trivially_destructible_v<YFastLeaf>) {
+            typename YFastTrie::XFastLeaf* xleaf = _trie.leftmost().xleaf;
+            while (xleaf != nullptr) {
+                if constexpr (requires { xleaf->value.nodes(); }) {
+                    for (auto leaf: xleaf->value.nodes()) {
+                        dispose(leaf);
+                    }
+                }
+                else {
+                    destroy_subtree(xleaf->value.root());
+                }
+                xleaf = xleaf->nxt;
+            }
         }
+        const auto release = ARENA && !empty();
         _trie.clear();
+        if constexpr (ARENA) {
+            if (release) {  // an empty (e.g. moved-from) container may share the arena with one holding entries
+                _trie.get_allocator().release();
+            }
+        }
     }
 
 private:
+    /**
+     * @return \a key itself if it is a \a Key or if \a Compare is transparent and \a BitExtractor takes \a K (so that
+     * no \a Key is constructed for the lookup); \a key converted to \a Key otherwise
+     */
+    template <typename K>
+    static decltype(auto) lookup_key(const K& key) {
+        if constexpr (std::is_same_v<K, Key> || internal::TransparentLookup<Compare, BitExtractor, K>) {
+            return (key);
+        }
+        else {
+            return Key(key);
+        }
+    }
+
+    template <typename Iterator, typename Lookup>
+    void batch(std::span<const Key> keys, std::span<Iterator> found, Lookup&& lookup) const {
+        constexpr std::size_t BATCH_WIDTH = 64;
+        typename YFastTrie::Where wheres[BATCH_WIDTH];
+        for (std::size_t i = 0; i < keys.size(); i += BATCH_WIDTH) {
+            const auto count = std::min(BATCH_WIDTH, keys.size() - i);
+            lookup(keys.subspan(i, count), std::span(wheres, count));
+            for (std::size_t j = 0; j < count; ++j) {
+                found[i + j] = Iterator(wheres[j]);
+            }
+        }
+    }
+
     void destroy_subtree(YFastLeaf* leaf) {
         if (leaf != nullptr) {
             destroy_subtree(leaf->left());
             destroy_subtree(leaf->right());
-            std::allocator_traits<Alloc>::destroy(_alloc, leaf);
+            dispose(leaf);
+        }
+    }
+
+    /**
+     * destroy a leaf and deallocate it unless it is left for the arena to release
+     */
+    void dispose(YFastLeaf* leaf) {
+        std::allocator_traits<Alloc>::destroy(_alloc, leaf);
+        if constexpr (!LEAF_ARENA) {
             std::allocator_traits<Alloc>::deallocate(_alloc, leaf, 1);
         }
     }
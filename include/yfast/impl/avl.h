@@ -2,6 +2,7 @@
 #define _YFAST_IMPL_AVL_H
 
 #include <functional>
+#include <span>
 
 #include <yfast/impl/bst.h>
 
@@ -38,12 +39,23 @@ public:
 protected:
     using BST<Node, Compare>::_cmp;
     using BST<Node, Compare>::_root;
+    using BST<Node, Compare>::_size;
 
 public:
     explicit AVL(Compare cmp = Compare()): AVL(nullptr, cmp) {}
     AVL(const AVL& other) = delete;
     AVL(AVL&& other) noexcept: BST<Node, Compare>(std::move(other)) {}
 
+    /**
+     * build a perfectly balanced tree of nodes at once, in linear time
+     * @param nodes nodes in ascending key order, without equal keys
+     * @return tree of \a nodes
+     */
+    static AVL build(std::span<Node* const> nodes, Compare cmp = Compare()) {
+        unsigned int height;
+        return AVL(build(nodes, height), nodes.size(), cmp);
+    }
+
     /**
      * @return the height of the tree
      */
@@ -69,12 +81,12 @@ public:
             return replaced;
         }
         node->set_balanced();
-        for (auto probe = node; probe != nullptr; probe = probe->parent) {
-            auto parent = probe->parent;
+        for (auto probe = node; probe != nullptr; probe = probe->parent()) {
+            auto parent = probe->parent();
             if (parent == nullptr) {
                 break;
             }
-            auto grand_parent = parent->parent;
+            auto grand_parent = parent->parent();
             Node* new_subroot;
             if (probe == parent->left()) {
                 if (parent->is_left_heavy()) {
@@ -125,7 +137,7 @@ public:
                 }
             }
             else {
-                new_subroot->parent = nullptr;
+                new_subroot->set_parent(nullptr);
                 _root = new_subroot;
             }
             break;
@@ -158,7 +170,7 @@ public:
 
         while (parent != nullptr) {
             bool sibling_balanced;
-            auto grand_parent = parent->parent;
+            auto grand_parent = parent->parent();
             if (is_left_child) {
                 auto sibling = parent->right();
                 if (parent->is_right_heavy()) {
@@ -220,7 +232,7 @@ public:
                 }
             }
             else {
-                new_subroot->parent = nullptr;
+                new_subroot->set_parent(nullptr);
                 _root = new_subroot;
             }
             if (sibling_balanced) {
@@ -239,10 +251,12 @@ public:
             return { AVL(_cmp), AVL(_cmp), nullptr };
         }
 
-        SplitResult split_result { AVL(_root->left(), _cmp), AVL(_root->right(), _cmp), _root };
+        const auto left_size = BST<Node, Compare>::count(_root->left());
+        SplitResult split_result { AVL(_root->left(), left_size, _cmp), AVL(_root->right(), _size - left_size - 1, _cmp), _root };
         split_result.left.insert(_root);
 
         _root = nullptr;
+        _size = 0;
 
         return split_result;
     }
@@ -258,7 +272,8 @@ public:
         auto& right = first_is_less ? subtree2 : subtree1;
         auto new_subroot = AVL::_leftmost(right._root);
         right.remove(new_subroot);
-        new_subroot->parent = nullptr;
+        new_subroot->set_parent(nullptr);
+        const auto size = left._size + right._size + 1;
         const auto left_height = left.height();
         const auto right_height = right.height();
 
@@ -266,7 +281,7 @@ public:
             auto probe = _rightmost(left._root);
             int probe_height = height(probe);
             while (probe_height < right_height) {
-                probe = probe->parent;
+                probe = probe->parent();
                 if (probe->is_left_heavy()) {
                     probe_height += 2;
                 }
@@ -275,7 +290,7 @@ public:
                 }
             }
 
-            auto parent = probe->parent;
+            auto parent = probe->parent();
             link_left(new_subroot, probe);
             link_right(new_subroot, right._root);
             link_right(parent, new_subroot);
@@ -291,7 +306,7 @@ public:
             }
 
             while (parent != nullptr) {
-                auto grand_parent = parent->parent;
+                auto grand_parent = parent->parent();
                 if (parent->is_right_heavy()) {
                     if (new_subroot->is_left_heavy()) {
                         auto node = rotate_right_left(parent, new_subroot);
@@ -299,7 +314,7 @@ public:
                             link_right(grand_parent, node);
                         }
                         else {
-                            node->parent = nullptr;
+                            node->set_parent(nullptr);
                             left._root = node;
                         }
                         break;  // subroot is not balanced
@@ -310,7 +325,7 @@ public:
                             link_right(grand_parent, node);
                         }
                         else {
-                            node->parent = nullptr;
+                            node->set_parent(nullptr);
                             left._root = node;
                         }
                         if (node->is_balanced()) {
@@ -331,7 +346,9 @@ public:
                 }
             }
 
+            left._size = size;
             right._root = nullptr;
+            right._size = 0;
             return std::move(left);
         }
 
@@ -339,7 +356,7 @@ public:
             auto probe = _leftmost(right._root);
             int probe_height = height(probe);
             while (probe_height < left_height) {
-                probe = probe->parent;
+                probe = probe->parent();
                 if (probe->is_right_heavy()) {
                     probe_height += 2;
                 }
@@ -348,7 +365,7 @@ public:
                 }
             }
 
-            auto parent = probe->parent;
+            auto parent = probe->parent();
             link_left(new_subroot, left._root);
             link_right(new_subroot, probe);
             link_left(parent, new_subroot);
@@ -364,7 +381,7 @@ public:
             }
 
             while (parent != nullptr) {
-                auto grand_parent = parent->parent;
+                auto grand_parent = parent->parent();
                 if (parent->is_left_heavy()) {
                     if (new_subroot->is_right_heavy()) {
                         auto node = rotate_left_right(parent, new_subroot);
@@ -372,7 +389,7 @@ public:
                             link_left(grand_parent, node);
                         }
                         else {
-                            node->parent = nullptr;
+                            node->set_parent(nullptr);
                             right._root = node;
                         }
                         break;  // subroot is not balanced
@@ -383,7 +400,7 @@ public:
                             link_left(grand_parent, node);
                         }
                         else {
-                            node->parent = nullptr;
+                            node->set_parent(nullptr);
                             right._root = node;
                         }
                         if (node->is_balanced()) {
@@ -404,7 +421,9 @@ public:
                 }
             }
 
+            right._size = size;
             left._root = nullptr;
+            left._size = 0;
             return std::move(right);
         }
 
@@ -421,12 +440,15 @@ public:
             new_subroot->set_balanced();
         }
         left._root = nullptr;
+        left._size = 0;
         right._root = nullptr;
-        return AVL(new_subroot, left._cmp);
+        right._size = 0;
+        return AVL(new_subroot, size, left._cmp);
     }
 
 protected:
     explicit AVL(Node* root, Compare cmp = Compare()): BST<Node, Compare>(root, cmp) {}
+    AVL(Node* root, std::size_t size, Compare cmp): BST<Node, Compare>(root, size, cmp) {}
 
     using BST<Node, Compare>::link_left;
     using BST<Node, Compare>::link_right;
@@ -436,6 +458,32 @@ protected:
     using BST<Node, Compare>::_rightmost;
 
 private:
+    /**
+     * @param height output: height of the subtree built
+     * @return root of the subtree built of \a nodes (the median); the left half takes the odd node, if any
+     */
+    static Node* build(std::span<Node* const> nodes, unsigned int& height) {
+        if (nodes.empty()) {
+            height = 0;
+            return nullptr;
+        }
+        const auto m = nodes.size() / 2;
+        auto node = nodes[m];
+        unsigned int left_height;
+        unsigned int right_height;
+        link_left(node, build(nodes.first(m), left_height));
+        link_right(node, build(nodes.subspan(m + 1), right_height));
+        if (left_height > right_height) {
+            node->set_left_heavy();
+        }
+        else {
+            node->set_balanced();
+        }
+        update_size(node);
+        height = left_height + 1;
+        return node;
+    }
+
     static unsigned int height(const Node* node) {
         if (node == nullptr) {
             return 0;
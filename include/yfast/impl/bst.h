@@ -1,12 +1,15 @@
 #ifndef _YFAST_IMPL_BST_H
 #define _YFAST_IMPL_BST_H
 
+#include <cstddef>
 #include <functional>
 
 namespace yfast::impl {
 
 /**
- * <a href="https://en.wikipedia.org/wiki/Binary_search_tree">Binary search tree</a> implementation
+ * <a href="https://en.wikipedia.org/wiki/Binary_search_tree">Binary search tree</a> implementation \n
+ * nodes may or may not store their subtree sizes (see \a yfast::internal::CompactBSTNodeBase); the tree counts its
+ * nodes either way
  * @tparam Node node type
  * @tparam Compare key comparator
  */
@@ -41,22 +44,26 @@ public:
     } RemoveReport;
 
 protected:
+    static constexpr bool SUBTREE_SIZES = requires (Node* node) { node->size; };
+
     Compare _cmp;
     Node* _root;
+    std::size_t _size;
 
 public:
     explicit BST(Compare cmp = Compare()): BST(nullptr, cmp) {}
 
     BST(const BST& other) = delete;
 
-    BST(BST&& other) noexcept: _cmp(other._cmp), _root(other._root) {
+    BST(BST&& other) noexcept: _cmp(other._cmp), _root(other._root), _size(other._size) {
         other._root = nullptr;
+        other._size = 0;
     }
 
     /**
      * @return the number of nodes in the tree
      */
-    [[nodiscard]] std::size_t size() const { return _root != nullptr ? _root->size : 0; }
+    [[nodiscard]] std::size_t size() const { return _size; }
 
     /**
      * @return pointer to the tree root
@@ -79,7 +86,8 @@ public:
      * @param key key to find
      * @return pointer to the node with the key equal to \a key or \a nullptr
      */
-    Node* find(const Key& key) const {
+    template <typename K = Key>
+    Node* find(const K& key) const {
         auto probe = _root;
         while (probe != nullptr) {
             if (_cmp(probe->key, key)) {
@@ -101,7 +109,8 @@ public:
      * @param strict whether a node with the key strictly less than \a key should be returned
      * @return pointer to the node with the maximal key either not greater or strictly less than \a key
      */
-    Node* pred(const Key& key, bool strict = false) const {
+    template <typename K = Key>
+    Node* pred(const K& key, bool strict = false) const {
         auto node = seek(key);
         if (node == nullptr) {
             return nullptr;
@@ -121,7 +130,8 @@ public:
      * @param strict whether a node with the key strictly greater than \a key should be returned
      * @return pointer to the node with the minimal key either not less or strictly greater than \a key
      */
-    Node* succ(const Key& key, bool strict = false) const {
+    template <typename K = Key>
+    Node* succ(const K& key, bool strict = false) const {
         auto node = seek(key);
         if (node == nullptr) {
             return nullptr;
@@ -157,7 +167,7 @@ public:
                 probe = parent->right();
             }
             else {  // replace
-                node->parent = parent;
+                node->set_parent(parent);
                 if (parent != nullptr) {
                     if (left_path) {  // NB: assigned if 'parent' non-null
                         parent->set_left(node);
@@ -171,15 +181,15 @@ public:
                 }
                 link_left(node, probe->left());
                 link_right(node, probe->right());
-                node->size = probe->size;
+                copy_size(node, probe);
                 return probe;
             }
         }
 
-        node->parent = parent;
+        node->set_parent(parent);
         node->set_left(nullptr);
         node->set_right(nullptr);
-        node->size = 1;
+        update_size(node);
 
         if (parent != nullptr) {
             if (left_path) {  // NB: assigned if 'parent' non-null
@@ -194,6 +204,7 @@ public:
         }
 
         inc_size_path(parent);
+        ++_size;
 
         return nullptr;
     }
@@ -204,7 +215,8 @@ public:
      * @return \a RemoveReport structure
      */
     RemoveReport remove(Node* node) {
-        auto parent = node->parent;
+        --_size;
+        auto parent = node->parent();
         bool left_path;
         if (parent != nullptr) {
             if (node == parent->left()) {
@@ -242,7 +254,7 @@ public:
             }
             else {
                 _root = node->right();
-                _root->parent = nullptr;
+                _root->set_parent(nullptr);
             }
             dec_size_path(parent);
             return { node->right(), parent, node->right(), left_path };
@@ -259,7 +271,7 @@ public:
             }
             else {
                 _root = node->left();
-                _root->parent = nullptr;
+                _root->set_parent(nullptr);
             }
             dec_size_path(parent);
             return { node->left(), parent, node->left(), left_path };
@@ -271,18 +283,18 @@ public:
         auto succ = BST::succ(node);
         if (succ == node->right()) {
             link_left(succ, node->left());
-            succ->size = node->size;
+            copy_size(succ, node);
             subtree_parent = succ;
             subtree_child = succ->right();
             is_left_child = false;
         }
         else {
-            subtree_parent = succ->parent;
+            subtree_parent = succ->parent();
             subtree_child = succ->right();
-            link_left(succ->parent, succ->right());
+            link_left(succ->parent(), succ->right());
             link_left(succ, node->left());
             link_right(succ, node->right());
-            succ->size = node->size;
+            copy_size(succ, node);
             is_left_child = true;
         }
         if (parent != nullptr) {
@@ -294,7 +306,7 @@ public:
             }
         }
         else {
-            succ->parent = nullptr;
+            succ->set_parent(nullptr);
             _root = succ;
         }
         dec_size_path(subtree_parent);
@@ -305,9 +317,9 @@ public:
         if (node->left() != nullptr) {
             return _rightmost(node->left());
         }
-        for (auto probe = node; probe->parent != nullptr; probe = probe->parent) {
-            if (probe == probe->parent->right()) {
-                return probe->parent;
+        for (auto probe = node; probe->parent() != nullptr; probe = probe->parent()) {
+            if (probe == probe->parent()->right()) {
+                return probe->parent();
             }
         }
         return nullptr;
@@ -317,22 +329,40 @@ public:
         if (node->right() != nullptr) {
             return _leftmost(node->right());
         }
-        for (auto probe = node; probe->parent != nullptr; probe = probe->parent) {
-            if (probe == probe->parent->left()) {
-                return probe->parent;
+        for (auto probe = node; probe->parent() != nullptr; probe = probe->parent()) {
+            if (probe == probe->parent()->left()) {
+                return probe->parent();
             }
         }
         return nullptr;
     }
 
 protected:
-    explicit BST(Node* root, Compare cmp = Compare()): _cmp(cmp), _root(root) {
+    explicit BST(Node* root, Compare cmp = Compare()): BST(root, count(root), cmp) {}
+
+    BST(Node* root, std::size_t size, Compare cmp): _cmp(cmp), _root(root), _size(size) {
         if (_root != nullptr) {
-            _root->parent = nullptr;
+            _root->set_parent(nullptr);
+        }
+    }
+
+    /**
+     * @return the number of nodes in the subtree of \a node; takes a traversal unless nodes store subtree sizes
+     */
+    static std::size_t count(const Node* node) {
+        if (node == nullptr) {
+            return 0;
+        }
+        if constexpr (SUBTREE_SIZES) {
+            return node->size;
+        }
+        else {
+            return 1 + count(node->left()) + count(node->right());
         }
     }
 
-    Node* seek(const Key& key) const {
+    template <typename K = Key>
+    Node* seek(const K& key) const {
         auto probe = _root;
         Node* parent = nullptr;
         while (probe != nullptr) {
@@ -372,7 +402,7 @@ protected:
             parent->set_left(child);
         }
         if (child != nullptr) {
-            child->parent = parent;
+            child->set_parent(parent);
         }
     }
 
@@ -381,35 +411,49 @@ protected:
             parent->set_right(child);
         }
         if (child != nullptr) {
-            child->parent = parent;
+            child->set_parent(parent);
+        }
+    }
+
+    static void copy_size(Node* node, const Node* other) {
+        if constexpr (SUBTREE_SIZES) {
+            node->size = other->size;
         }
     }
 
     static void update_size(Node* node) {
-        if (node != nullptr) {
-            auto left = node->left();
-            auto left_size = left != nullptr ? left->size : 0;
-            auto right = node->right();
-            auto right_size = right != nullptr ? right->size : 0;
-            node->size = 1 + left_size + right_size;
+        if constexpr (SUBTREE_SIZES) {
+            if (node != nullptr) {
+                auto left = node->left();
+                auto left_size = left != nullptr ? left->size : 0;
+                auto right = node->right();
+                auto right_size = right != nullptr ? right->size : 0;
+                node->size = 1 + left_size + right_size;
+            }
         }
     }
 
     static void update_size_path(Node* node) {
-        for (auto ancestor = node; ancestor != nullptr; ancestor = ancestor->parent) {
-            update_size(ancestor);
+        if constexpr (SUBTREE_SIZES) {
+            for (auto ancestor = node; ancestor != nullptr; ancestor = ancestor->parent()) {
+                update_size(ancestor);
+            }
         }
     }
 
     static void inc_size_path(Node* node) {
-        for (auto ancestor = node; ancestor != nullptr; ancestor = ancestor->parent) {
-            ++(ancestor->size);
+        if constexpr (SUBTREE_SIZES) {
+            for (auto ancestor = node; ancestor != nullptr; ancestor = ancestor->parent()) {
+                ++(ancestor->size);
+            }
         }
     }
 
     static void dec_size_path(Node* node) {
-        for (auto ancestor = node; ancestor != nullptr; ancestor = ancestor->parent) {
-            --(ancestor->size);
+        if constexpr (SUBTREE_SIZES) {
+            for (auto ancestor = node; ancestor != nullptr; ancestor = ancestor->parent()) {
+                --(ancestor->size);
+            }
         }
     }
 };
@@ -0,0 +1,290 @@
+#ifndef _YFAST_IMPL_SORTED_ARRAY_H
+#define _YFAST_IMPL_SORTED_ARRAY_H
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <type_traits>
+
+#include <yfast/internal/simd_search.h>
+#include <yfast/utils/prefetch.h>
+
+namespace yfast::impl {
+
+/**
+ * sorted array of at most \a N nodes along with a copy of their keys, i.e. a bucket searched by scanning contiguous
+ * keys rather than by chasing pointers \n
+ * nodes are neither linked to nor moved by the array, so pointers to them stay valid; stepping from a node to its
+ * neighbor, however, takes a search (see \a pred(Node*) and \a succ(Node*))
+ * @tparam Node node type; only its \a key is used
+ * @tparam N capacity; undefined behavior if exceeded
+ * @tparam Compare key comparator
+ */
+template <typename Node, std::size_t N, typename Compare = std::less<typename Node::Key>>
+class SortedArray {
+public:
+    /**
+     * node key type
+     */
+    typedef typename Node::Key Key;
+
+    static_assert(std::is_trivially_copyable_v<Key> && std::is_default_constructible_v<Key>, "Sorted array requires trivially copyable keys");
+
+    /**
+     * structure returned by the \a split() method
+     */
+    typedef struct {
+        /**
+         * left (the lesser) half
+         */
+        SortedArray left;
+        /**
+         * right (the greater) half
+         */
+        SortedArray right;
+        /**
+         * pointer to the node with maximal key in the left half
+         */
+        Node* left_max;
+    } SplitResult;
+
+private:
+    // ranges of up to two cache lines of keys are scanned rather than halved, i.e. integral keys take one or two
+    // AVX-512 compares (see yfast::internal::count_less())
+    static constexpr std::size_t SCAN_WIDTH = std::max<std::size_t>(128 / sizeof(Key), 4);
+
+    Compare _cmp;
+    std::size_t _size;
+    Key _keys[N];
+    Node* _nodes[N];
+
+public:
+    explicit SortedArray(Compare cmp = Compare()): _cmp(cmp), _size(0) {}
+    SortedArray(const SortedArray& other) = delete;
+
+    SortedArray(SortedArray&& other) noexcept: _cmp(other._cmp), _size(other._size) {
+        std::copy(other._keys, other._keys + _size, _keys);
+        std::copy(other._nodes, other._nodes + _size, _nodes);
+        other._size = 0;
+    }
+
+    /**
+     * build an array of nodes at once
+     * @param nodes at most \a N nodes in ascending key order, without equal keys
+     * @return array of \a nodes
+     */
+    static SortedArray build(std::span<Node* const> nodes, Compare cmp = Compare()) {
+        SortedArray array(cmp);
+        for (auto node: nodes) {
+            array._keys[array._size] = node->key;
+            array._nodes[array._size++] = node;
+        }
+        return array;
+    }
+
+    /**
+     * @return the number of nodes in the array
+     */
+    [[nodiscard]] std::size_t size() const { return _size; }
+
+    /**
+     * @return pointer to the median node (the one \a split() puts last into the left half)
+     */
+    Node* root() const { return _size > 0 ? _nodes[_size / 2] : nullptr; }
+
+    /**
+     * @return pointer to the node with the minimal key in the array
+     */
+    Node* leftmost() const { return _size > 0 ? _nodes[0] : nullptr; }
+
+    /**
+     * @return pointer to the node with the maximal key in the array
+     */
+    Node* rightmost() const { return _size > 0 ? _nodes[_size - 1] : nullptr; }
+
+    /**
+     * @return all the nodes in key order
+     */
+    std::span<Node* const> nodes() const { return { _nodes, _size }; }
+
+    /**
+     * hint the CPU to start loading the keys a search probes first
+     */
+    void prefetch() const {
+        utils::prefetch(_keys + _size / 2);
+    }
+
+    /**
+     * find a node with an equal key \n
+     * keys \a key1 and \a key2 are considered equal if neither \a cmp(key1, key2) nor \a cmp(key2, key1)
+     * @param key key to find
+     * @return pointer to the node with the key equal to \a key or \a nullptr
+     */
+    template <typename K = Key>
+    Node* find(const K& key) const {
+        const auto i = rank(key);
+        return i < _size && !_cmp(key, _keys[i]) ? _nodes[i] : nullptr;
+    }
+
+    /**
+     * find a predecessor node for a key
+     * @param key key
+     * @param strict whether a node with the key strictly less than \a key should be returned
+     * @return pointer to the node with the maximal key either not greater or strictly less than \a key
+     */
+    template <typename K = Key>
+    Node* pred(const K& key, bool strict = false) const {
+        const auto i = rank(key);
+        if (!strict && i < _size && !_cmp(key, _keys[i])) {
+            return _nodes[i];
+        }
+        return i > 0 ? _nodes[i - 1] : nullptr;
+    }
+
+    /**
+     * find a successor node for a key
+     * @param key key
+     * @param strict whether a node with the key strictly greater than \a key should be returned
+     * @return pointer to the node with the minimal key either not less or strictly greater than \a key
+     */
+    template <typename K = Key>
+    Node* succ(const K& key, bool strict = false) const {
+        auto i = rank(key);
+        if (strict && i < _size && !_cmp(key, _keys[i])) {
+            ++i;
+        }
+        return i < _size ? _nodes[i] : nullptr;
+    }
+
+    /**
+     * @param node node in the array
+     * @return pointer to the preceding node or \a nullptr
+     */
+    Node* pred(Node* node) const {
+        const auto i = rank(node->key);
+        return i > 0 ? _nodes[i - 1] : nullptr;
+    }
+
+    /**
+     * @param node node in the array
+     * @return pointer to the following node or \a nullptr
+     */
+    Node* succ(Node* node) const {
+        const auto i = rank(node->key) + 1;
+        return i < _size ? _nodes[i] : nullptr;
+    }
+
+    /**
+     * insert a new node, replacing node with the equal key (if any)
+     * @param node node to insert
+     * @return node being replaced or \a nullptr
+     */
+    Node* insert(Node* node) {
+        const auto i = rank(node->key);
+        if (i < _size && !_cmp(node->key, _keys[i])) {
+            auto replaced = _nodes[i];
+            _nodes[i] = node;
+            return replaced;
+        }
+        std::copy_backward(_keys + i, _keys + _size, _keys + _size + 1);
+        std::copy_backward(_nodes + i, _nodes + _size, _nodes + _size + 1);
+        _keys[i] = node->key;
+        _nodes[i] = node;
+        ++_size;
+        return nullptr;
+    }
+
+    /**
+     * remove a node
+     * @param node node to remove; undefined behavior if not in the array
+     */
+    void remove(Node* node) {
+        const auto i = rank(node->key);
+        std::copy(_keys + i + 1, _keys + _size, _keys + i);
+        std::copy(_nodes + i + 1, _nodes + _size, _nodes + i);
+        --_size;
+    }
+
+    /**
+     * split the array by the median node; the median node goes to the left half
+     * @return \a SplitResult structure
+     */
+    SplitResult split() {
+        if (_size == 0) {
+            return { SortedArray(_cmp), SortedArray(_cmp), nullptr };
+        }
+
+        const auto m = _size / 2 + 1;
+        SplitResult split_result { SortedArray(_cmp), SortedArray(_cmp), _nodes[m - 1] };
+        split_result.left.append(*this, 0, m);
+        split_result.right.append(*this, m, _size);
+
+        _size = 0;
+
+        return split_result;
+    }
+
+    /**
+     * merge two arrays \n
+     * undefined behavior unless the maximal key in either array is less than the minimal key in the other
+     * @return merged array
+     */
+    static SortedArray merge(SortedArray&& array1, SortedArray&& array2) {
+        if (array1._size == 0) {
+            return std::move(array2);
+        }
+        if (array2._size == 0) {
+            return std::move(array1);
+        }
+        auto first_is_less = array1._cmp(array1._keys[0], array2._keys[0]);
+        auto& left = first_is_less ? array1 : array2;
+        auto& right = first_is_less ? array2 : array1;
+        SortedArray merged(left._cmp);
+        merged.append(left, 0, left._size);
+        merged.append(right, 0, right._size);
+        left._size = 0;
+        right._size = 0;
+        return merged;
+    }
+
+private:
+    /**
+     * @return the number of keys less than \a key
+     */
+    template <typename K>
+    std::size_t rank(const K& key) const {
+        std::size_t l = 0;
+        std::size_t r = _size;
+        while (r - l > SCAN_WIDTH) {
+            const auto m = (l + r) / 2;
+            if (_cmp(_keys[m], key)) {
+                l = m + 1;
+            }
+            else {
+                r = m;
+            }
+        }
+        if constexpr (std::is_same_v<K, Key> && internal::simd_searchable_v<Key> && (std::is_same_v<Compare, std::less<Key>> || std::is_same_v<Compare, std::less<>>)) {
+            return l + internal::count_less(_keys + l, r - l, key);
+        }
+        else {
+            // no early exit, so that the scan compiles into branchless (and possibly vectorized) code
+            auto count = l;
+            for (auto i = l; i < r; ++i) {
+                count += _cmp(_keys[i], key);
+            }
+            return count;
+        }
+    }
+
+    void append(const SortedArray& other, std::size_t begin, std::size_t end) {
+        std::copy(other._keys + begin, other._keys + end, _keys + _size);
+        std::copy(other._nodes + begin, other._nodes + end, _nodes + _size);
+        _size += end - begin;
+    }
+};
+
+}
+
+#endif
@@ -1,12 +1,17 @@
 #ifndef _YFAST_IMPL_XFAST_H
 #define _YFAST_IMPL_XFAST_H
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <span>
+#include <type_traits>
 
 #include <yfast/internal/bit_extractor.h>
 #include <yfast/internal/concepts.h>
 #include <yfast/internal/default_hash.h>
+#include <yfast/internal/level_storage.h>
 #include <yfast/internal/xfast.h>
 
 namespace yfast::impl {
@@ -16,15 +21,18 @@ namespace yfast::impl {
  * @tparam Leaf leaf type
  * @tparam H key length in bits
  * @tparam BitExtractor helper type to provide key shifts and bit extractions
- * @tparam Hash map from shifted keys to \a std::uintptr_t
+ * @tparam Hash map from shifted keys to \a std::uintptr_t (one per level) or level storage policy such as
+ * \a yfast::internal::UnifiedLevels
  * @tparam Compare key comparator
+ * @tparam ArbitraryAllocator allocator rebound for the default level maps (see \a yfast::internal::LevelStorage)
  */
 template <
     typename Leaf,
     unsigned int H,
     internal::BitExtractorGeneric<typename Leaf::Key> BitExtractor = internal::BitExtractor<typename Leaf::Key>,
-    internal::MapGeneric<typename BitExtractor::ShiftResult, std::uintptr_t> Hash = internal::DefaultHash<typename BitExtractor::ShiftResult, std::uintptr_t>,
-    typename Compare = std::less<typename Leaf::Key>
+    internal::LevelHashGeneric<typename BitExtractor::ShiftResult> Hash = internal::DefaultHash<typename BitExtractor::ShiftResult, std::uintptr_t>,
+    typename Compare = std::less<typename Leaf::Key>,
+    typename ArbitraryAllocator = std::allocator<typename Leaf::Key>
 >
 class XFastTrie {
 public:
@@ -33,6 +41,11 @@ public:
      */
     typedef typename Leaf::Key Key;
 
+    /**
+     * number of keys whose lookups are interleaved by batch operations
+     */
+    static constexpr std::size_t BATCH_WIDTH = 16;
+
 protected:
     typedef enum {EMPTY, MISSED_LEFT, ON_TARGET, MISSED_RIGHT} Missed;
 
@@ -44,18 +57,22 @@ protected:
 
     typedef internal::XFastNode<Leaf> Node;
 
+    typedef typename BitExtractor::ShiftResult ShiftResult;
+
+    typedef internal::LevelStorage<Hash, ShiftResult, H, ArbitraryAllocator> Storage;
+
 private:
     BitExtractor _bx;
     Compare _cmp;
     Node _root;
     Leaf* _leftmost;
     Leaf* _rightmost;
-    Hash _hash[H];
+    Storage _levels;
 
 public:
-    explicit XFastTrie(BitExtractor bx = BitExtractor(), Compare cmp = Compare()): _bx(bx), _cmp(cmp), _root(nullptr, false, false), _leftmost(nullptr), _rightmost(nullptr) {}
+    explicit XFastTrie(BitExtractor bx = BitExtractor(), Compare cmp = Compare(), ArbitraryAllocator alloc = ArbitraryAllocator()): _bx(bx), _cmp(cmp), _root(nullptr, false, false), _leftmost(nullptr), _rightmost(nullptr), _levels(make_levels(alloc)) {}
     XFastTrie(const XFastTrie& other) = delete;
-    XFastTrie(XFastTrie&& other) noexcept: _bx(other._bx), _cmp(other._cmp), _root(other._root), _leftmost(other._leftmost), _rightmost(other._rightmost), _hash(std::move(other._hash)) {
+    XFastTrie(XFastTrie&& other) noexcept: _bx(other._bx), _cmp(other._cmp), _root(other._root), _leftmost(other._leftmost), _rightmost(other._rightmost), _levels(std::move(other._levels)) {
         other._root = Node(nullptr, false, false);
         other._leftmost = nullptr;
         other._rightmost = nullptr;
@@ -64,7 +81,13 @@ public:
     /**
      * @return the number of leaves in the trie
      */
-    [[nodiscard]] std::size_t size() const { return _hash[0].size(); }
+    [[nodiscard]] std::size_t size() const { return _levels.size(); }
+
+    /**
+     * allocate room in the level tables (if supported by \a Hash) to avoid rehashing while growing
+     * @param n expected number of leaves
+     */
+    void reserve(std::size_t n) { _levels.reserve(n); }
 
     /**
      * @return pointer to the leaf with the minimal key in the trie
@@ -81,12 +104,9 @@ public:
      * @param key key to find
      * @return pointer to the leaf with the key equal to \a key or \a nullptr
      */
-    Leaf* find(const Key& key) const {
-        auto key_ = _bx.shift(key, 0);
-        if (_hash[0].contains(key_)) {
-            return reinterpret_cast<Leaf*>(_hash[0].at(key_));
-        }
-        return nullptr;
+    template <typename K = Key>
+    Leaf* find(const K& key) const {
+        return reinterpret_cast<Leaf*>(_levels.lookup(0, _bx.shift(key, 0)));
     }
 
     /**
@@ -95,17 +115,27 @@ public:
      * @param strict whether a leaf with the key strictly less than \a key should be returned
      * @return pointer to the leaf with the maximal key either not greater or strictly less than \a key
      */
-    Leaf* pred(const Key& key, bool strict = false) const {
-        auto [guess, missed, level] = approx(key);
-        switch (missed) {
-            case EMPTY:
-                return nullptr;
-            case MISSED_LEFT:
-                return guess;
-            case ON_TARGET:
-                return strict ? guess->prv : guess;
-            case MISSED_RIGHT:
-                return guess->prv;
+    template <typename K = Key>
+    Leaf* pred(const K& key, bool strict = false) const {
+        return pred(approx(internal::key_shifts(_bx, key)), strict);
+    }
+
+    /**
+     * find predecessor leaves for a batch of keys; binary searches over levels are interleaved so that the hash
+     * probes of different keys overlap
+     * @param keys keys
+     * @param leaves output: pointers to the leaves with the maximal keys either not greater or strictly less than
+     * \a keys (same size as \a keys)
+     * @param strict whether leaves with keys strictly less than \a keys should be returned
+     */
+    void pred_batch(std::span<const Key> keys, std::span<Leaf*> leaves, bool strict = false) const {
+        ApproxReport reports[BATCH_WIDTH];
+        for (std::size_t i = 0; i < keys.size(); i += BATCH_WIDTH) {
+            const auto count = std::min(BATCH_WIDTH, keys.size() - i);
+            approx_batch(keys.subspan(i, count), reports);
+            for (std::size_t j = 0; j < count; ++j) {
+                leaves[i + j] = pred(reports[j], strict);
+            }
         }
     }
 
@@ -115,17 +145,27 @@ public:
      * @param strict whether a leaf with the key strictly greater than \a key should be returned
      * @return pointer to the leaf with the minimal key either not less or strictly greater than \a key
      */
-    Leaf* succ(const Key& key, bool strict = false) const {
-        auto [guess, missed, level] = approx(key);
-        switch (missed) {
-            case EMPTY:
-                return nullptr;
-            case MISSED_LEFT:
-                return guess->nxt;
-            case ON_TARGET:
-                return strict ? guess->nxt : guess;
-            case MISSED_RIGHT:
-                return guess;
+    template <typename K = Key>
+    Leaf* succ(const K& key, bool strict = false) const {
+        return succ(approx(internal::key_shifts(_bx, key)), strict);
+    }
+
+    /**
+     * find successor leaves for a batch of keys; binary searches over levels are interleaved so that the hash
+     * probes of different keys overlap
+     * @param keys keys
+     * @param leaves output: pointers to the leaves with the minimal keys either not less or strictly greater than
+     * \a keys (same size as \a keys)
+     * @param strict whether leaves with keys strictly greater than \a keys should be returned
+     */
+    void succ_batch(std::span<const Key> keys, std::span<Leaf*> leaves, bool strict = false) const {
+        ApproxReport reports[BATCH_WIDTH];
+        for (std::size_t i = 0; i < keys.size(); i += BATCH_WIDTH) {
+            const auto count = std::min(BATCH_WIDTH, keys.size() - i);
+            approx_batch(keys.subspan(i, count), reports);
+            for (std::size_t j = 0; j < count; ++j) {
+                leaves[i + j] = succ(reports[j], strict);
+            }
         }
     }
 
@@ -137,7 +177,8 @@ public:
     Leaf* insert(Leaf* leaf) {
         Leaf* prv;
         Leaf* nxt;
-        auto [guess, missed, level] = approx(leaf->key);
+        const auto key_prefix = internal::key_shifts(_bx, leaf->key);
+        auto [guess, missed, level] = approx(key_prefix);
         switch (missed) {
             case EMPTY:
                 _root = Node(leaf, false, false);
@@ -149,7 +190,7 @@ public:
                 nxt = guess->nxt;
                 break;
             case ON_TARGET:
-                _hash[0][_bx.shift(leaf->key, 0)] = reinterpret_cast<std::uintptr_t>(leaf);
+                _levels.entry(0, key_prefix(0)) = reinterpret_cast<std::uintptr_t>(leaf);
                 return guess;
             case MISSED_RIGHT:
                 prv = guess->prv;
@@ -184,29 +225,28 @@ public:
             _root.set_descendant(leaf);
         }
 
+        // NB: a single probe per level: entry() yields a mutable slot, value-initialized (i.e. zero) if just inserted
         for (unsigned int h = H - 1; h >= level; --h) {
-            auto key_prefix = _bx.shift(leaf->key, h);
-            std::uintptr_t value = _hash[h].at(key_prefix);
+            std::uintptr_t& value = _levels.entry(h, key_prefix(h));
             Node node = value;
             if (!node.left_present()) {
                 if (_cmp(leaf->key, node.descendant()->key)) {
                     node.set_descendant(leaf);
-                    _hash[h][key_prefix] = node.value;
+                    value = node.value;
                 }
             }
             if (!node.right_present()) {
                 if (_cmp(node.descendant()->key, leaf->key)) {
                     node.set_descendant(leaf);
-                    _hash[h][key_prefix] = node.value;
+                    value = node.value;
                 }
             }
         }
 
         for (unsigned int h = std::min(level, H - 1); h > 0; --h) {
             next_bit = _bx.extract_bit(leaf->key, h - 1);
-            auto key_prefix = _bx.shift(leaf->key, h);
-            if (_hash[h].contains(key_prefix)) {
-                std::uintptr_t value = _hash[h].at(key_prefix);
+            std::uintptr_t& value = _levels.entry(h, key_prefix(h));
+            if (value != 0) {
                 Node node = value;
                 if (next_bit) {
                     node.set_right_present();
@@ -224,15 +264,15 @@ public:
                         }
                     }
                 }
-                _hash[h][key_prefix] = node.value;
+                value = node.value;
             }
             else {
                 Node node(leaf, !next_bit, next_bit);
-                _hash[h][key_prefix] = node.value;
+                value = node.value;
             }
         }
 
-        _hash[0][_bx.shift(leaf->key, 0)] = reinterpret_cast<std::uintptr_t>(leaf);
+        _levels.entry(0, key_prefix(0)) = reinterpret_cast<std::uintptr_t>(leaf);
 
         if (_leftmost == nullptr || _cmp(leaf->key, _leftmost->key)) {
             _leftmost = leaf;
@@ -258,48 +298,43 @@ public:
             nxt->prv = prv;
         }
 
-        _hash[0].erase(_bx.shift(leaf->key, 0));
+        const auto key_prefix = internal::key_shifts(_bx, leaf->key);
+        _levels.erase(0, key_prefix(0));
 
         bool subtree_removed = true;
         for (unsigned int h = 1; h < H; ++h) {
-            auto key_prefix = _bx.shift(leaf->key, h);
-            std::uintptr_t value = _hash[h].at(key_prefix);
-            Node node = value;
-            if (subtree_removed) {
-                if (_bx.extract_bit(leaf->key, h - 1)) {
-                    node.clear_right_present();
-                    if (node.left_present()) {
+            _levels.modify(h, key_prefix(h), [&] (std::uintptr_t& value) {
+                Node node = value;
+                if (subtree_removed) {
+                    if (_bx.extract_bit(leaf->key, h - 1)) {
+                        node.clear_right_present();
+                        if (!node.left_present()) {
+                            return false;
+                        }
                         node.set_descendant(prv);
-                        _hash[h][key_prefix] = node.value;
-                        subtree_removed = false;
                     }
                     else {
-                        _hash[h].erase(key_prefix);
-                    }
-                }
-                else {
-                    node.clear_left_present();
-                    if (node.right_present()) {
+                        node.clear_left_present();
+                        if (!node.right_present()) {
+                            return false;
+                        }
                         node.set_descendant(nxt);
-                        _hash[h][key_prefix] = node.value;
-                        subtree_removed = false;
-                    }
-                    else {
-                        _hash[h].erase(key_prefix);
                     }
+                    subtree_removed = false;
                 }
-            }
-            else {
-                if (node.descendant() == leaf) {
-                    if (!node.left_present()) {
-                        node.set_descendant(nxt);
-                    }
-                    if (!node.right_present()) {
-                        node.set_descendant(prv);
+                else {
+                    if (node.descendant() == leaf) {
+                        if (!node.left_present()) {
+                            node.set_descendant(nxt);
+                        }
+                        if (!node.right_present()) {
+                            node.set_descendant(prv);
+                        }
                     }
-                    _hash[h][key_prefix] = node.value;
                 }
-            }
+                value = node.value;
+                return true;
+            });
         }
 
         if (subtree_removed) {
@@ -345,57 +380,154 @@ public:
      * remove all the internal nodes; leaves are neither deallocated nor destroyed
      */
     void clear() {
-        for (unsigned int h = 0; h < H; ++h) {
-            _hash[h].clear();
-        }
+        _levels.clear();
         _root = Node(nullptr, false, false);
         _leftmost = nullptr;
         _rightmost = nullptr;
     }
 
 private:
-    ApproxReport approx(const Key& key) const {
+    static Storage make_levels(const ArbitraryAllocator& alloc) {
+        if constexpr (std::is_constructible_v<Storage, const ArbitraryAllocator&>) {
+            return Storage(alloc);
+        }
+        else {
+            return Storage();
+        }
+    }
+
+    static Leaf* pred(const ApproxReport& report, bool strict) {
+        auto [guess, missed, level] = report;
+        switch (missed) {
+            case EMPTY:
+                return nullptr;
+            case MISSED_LEFT:
+                return guess;
+            case ON_TARGET:
+                return strict ? guess->prv : guess;
+            case MISSED_RIGHT:
+                return guess->prv;
+        }
+    }
+
+    static Leaf* succ(const ApproxReport& report, bool strict) {
+        auto [guess, missed, level] = report;
+        switch (missed) {
+            case EMPTY:
+                return nullptr;
+            case MISSED_LEFT:
+                return guess->nxt;
+            case ON_TARGET:
+                return strict ? guess->nxt : guess;
+            case MISSED_RIGHT:
+                return guess;
+        }
+    }
+
+    /**
+     * @param key_prefix shifts of the key (see \a yfast::internal::key_shifts())
+     */
+    template <typename Shifts>
+    ApproxReport approx(const Shifts& key_prefix) const {
         if (!_root.left_present() && !_root.right_present()) {
             return {nullptr, EMPTY, H };
         }
 
         unsigned int l = 0;
         unsigned int r = H;
-        unsigned int m;
+        Node node = _root;
         while (r - l > 1) {  // ln H
-            m = (r + l) / 2;
-            if (_hash[m].contains(_bx.shift(key, m))) {
+            auto m = (r + l) / 2;
+            std::uintptr_t value = _levels.lookup(m, key_prefix(m));
+            if (value != 0) {
                 r = m;
+                node.value = value;
             }
             else {
                 l = m;
             }
         }
-        if (_hash[l].contains(_bx.shift(key, l))) {
-            m = l;
+        // 'l' has only been probed (and missed) unless it is still zero
+        if (l == 0) {
+            std::uintptr_t value = _levels.lookup(0, key_prefix(0));
+            if (value != 0) {
+                return { reinterpret_cast<Leaf*>(value), ON_TARGET, 0 };
+            }
+        }
+
+        if (node.left_present()) {
+            return { node.descendant(), MISSED_LEFT, r };
         }
         else {
-            m = r;
+            return { node.descendant(), MISSED_RIGHT, r };
         }
+    }
 
-        if (m == 0) {
-            std::uintptr_t value = _hash[0].at(_bx.shift(key, 0));
-            return {reinterpret_cast<Leaf*>(value), ON_TARGET, 0 };
+    /**
+     * \a approx() for up to \a BATCH_WIDTH keys in lockstep: every round first prefetches the next probe of each key
+     * and only then resolves them, so that cache misses of different keys overlap
+     * @param keys keys (at most \a BATCH_WIDTH)
+     * @param reports output: reports for \a keys
+     */
+    void approx_batch(std::span<const Key> keys, ApproxReport* reports) const {
+        const auto count = keys.size();
+        if (!_root.left_present() && !_root.right_present()) {
+            std::fill(reports, reports + count, ApproxReport { nullptr, EMPTY, H });
+            return;
         }
 
-        Node node;
-        if (m < H) {
-            std::uintptr_t value = _hash[m].at(_bx.shift(key, m));
-            node.value = value;
+        unsigned int l[BATCH_WIDTH];
+        unsigned int r[BATCH_WIDTH];
+        Node node[BATCH_WIDTH];
+        decltype(internal::key_shifts(_bx, keys[0])) key_shifts[BATCH_WIDTH];
+        ShiftResult key_prefix[BATCH_WIDTH];
+        for (std::size_t i = 0; i < count; ++i) {
+            key_shifts[i] = internal::key_shifts(_bx, keys[i]);
+            l[i] = 0;
+            r[i] = H;
+            node[i] = _root;
         }
-        else {
-            node = _root;
+
+        for (bool active = H > 1; active; ) {  // ln H rounds
+            for (std::size_t i = 0; i < count; ++i) {
+                if (r[i] - l[i] > 1) {
+                    const auto m = (r[i] + l[i]) / 2;
+                    key_prefix[i] = key_shifts[i](m);
+                    _levels.prefetch(m, key_prefix[i]);
+                }
+            }
+            active = false;
+            for (std::size_t i = 0; i < count; ++i) {
+                if (r[i] - l[i] > 1) {
+                    const auto m = (r[i] + l[i]) / 2;
+                    std::uintptr_t value = _levels.lookup(m, key_prefix[i]);
+                    if (value != 0) {
+                        r[i] = m;
+                        node[i].value = value;
+                    }
+                    else {
+                        l[i] = m;
+                    }
+                    active |= r[i] - l[i] > 1;
+                }
+            }
         }
-        if (node.left_present()) {
-            return { node.descendant(), MISSED_LEFT, m };
+
+        for (std::size_t i = 0; i < count; ++i) {
+            if (l[i] == 0) {
+                key_prefix[i] = key_shifts[i](0);
+                _levels.prefetch(0, key_prefix[i]);
+            }
         }
-        else {
-            return { node.descendant(), MISSED_RIGHT, m };
+        for (std::size_t i = 0; i < count; ++i) {
+            if (l[i] == 0) {
+                std::uintptr_t value = _levels.lookup(0, key_prefix[i]);
+                if (value != 0) {
+                    reports[i] = { reinterpret_cast<Leaf*>(value), ON_TARGET, 0 };
+                    continue;
+                }
+            }
+            reports[i] = { node[i].descendant(), node[i].left_present() ? MISSED_LEFT : MISSED_RIGHT, r[i] };
         }
     }
 };
@@ -1,47 +1,63 @@
 #ifndef _YFAST_IMPL_YFAST_H
 #define _YFAST_IMPL_YFAST_H
 
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <span>
+#include <type_traits>
 
-#include <yfast/impl/avl.h>
+#include <yfast/internal/bucket.h>
 #include <yfast/internal/concepts.h>
 #include <yfast/internal/bit_extractor.h>
 #include <yfast/internal/yfast.h>
 #include <yfast/internal/default_hash.h>
+#include <yfast/internal/thresholds.h>
+#include <yfast/utils/prefetch.h>
 
 namespace yfast::impl {
 
 /**
  * <a href="https://en.wikipedia.org/wiki/Y-fast_trie">y-fast trie</a> implementation
- * @tparam Leaf inner binary tree leaf type
+ * @tparam Leaf bucket leaf type
  * @tparam H key length in bits
  * @tparam BitExtractor helper type to provide key shifts and bit extractions
- * @tparam Hash map from shifted keys to \a std::uintptr_t
+ * @tparam Hash map from shifted keys to \a std::uintptr_t (one per level) or level storage policy such as
+ * \a yfast::internal::UnifiedLevels
  * @tparam Compare key comparator
  * @tparam ArbitraryAllocator allocator
+ * @tparam Buckets bucket policy: \a yfast::internal::AVLBuckets or \a yfast::internal::SortedArrayBuckets, optionally
+ * wrapped into \a yfast::internal::MinimumRepresentatives
+ * @tparam Thresholds bucket split/merge threshold policy: \a yfast::internal::DefaultThresholds,
+ * \a yfast::internal::FixedThresholds or \a yfast::internal::AdaptiveThresholds
  */
 template <
     typename Leaf,
     unsigned int H,
     internal::BitExtractorGeneric<typename Leaf::Key> BitExtractor = internal::BitExtractor<typename Leaf::Key>,
-    internal::MapGeneric<typename BitExtractor::ShiftResult, std::uintptr_t> Hash = internal::DefaultHash<typename BitExtractor::ShiftResult, std::uintptr_t>,
+    internal::LevelHashGeneric<typename BitExtractor::ShiftResult> Hash = internal::DefaultHash<typename BitExtractor::ShiftResult, std::uintptr_t>,
     typename Compare = std::less<typename Leaf::Key>,
-    typename ArbitraryAllocator = std::allocator<typename Leaf::Key>
+    typename ArbitraryAllocator = std::allocator<typename Leaf::Key>,
+    internal::BucketPolicyGeneric<Leaf, Compare> Buckets = internal::AVLBuckets,
+    internal::ThresholdPolicyGeneric<H> Thresholds = internal::DefaultThresholds
 >
 class YFastTrie {
     static_assert(H >= 8, "Key length too short");
 
+    typedef typename Thresholds::template Thresholds<H> TreeThresholds;
+    static constexpr unsigned int FINGER_STEPS = 2;
+    static constexpr bool MIN_REPRESENTATIVES = internal::min_representatives_v<Buckets>;
+
 public:
     typedef typename Leaf::Key Key;
-    typedef AVL<Leaf, Compare> Value;
+    // a merge may outgrow the split threshold by less than the merge threshold before it is split
+    typedef typename Buckets::template Bucket<Leaf, Compare, TreeThresholds::MAX_SPLIT + TreeThresholds::MAX_MERGE> Value;
     typedef internal::XFastLeaf<Key, Value> XFastLeaf;
 
 private:
     typedef typename std::allocator_traits<ArbitraryAllocator>::template rebind_alloc<XFastLeaf> Alloc;
-
-    static constexpr auto TREE_SPLIT_THRESHOLD = 2 * H;
-    static constexpr auto TREE_MERGE_THRESHOLD = H / 4;
+    // an arena is released on clear() from under the level maps, which thus keep the default allocator
+    typedef std::conditional_t<internal::ArenaAllocatorGeneric<Alloc>, std::allocator<Key>, ArbitraryAllocator> LevelAlloc;
 
 public:
     /**
@@ -57,7 +73,7 @@ public:
          */
         XFastLeaf* xleaf;
         /**
-         * pointer to the leaf in the underlying AVL tree
+         * pointer to the leaf in the bucket
          */
         Leaf* leaf;
     };
@@ -70,13 +86,14 @@ public:
 private:
     Alloc _alloc;
     Compare _cmp;
-    XFastTrie<XFastLeaf, H, BitExtractor, Hash, Compare> _trie;
+    XFastTrie<XFastLeaf, H, BitExtractor, Hash, Compare, LevelAlloc> _trie;
     unsigned int _rebuilds;
     std::size_t _size;
+    TreeThresholds _thresholds;
 
 public:
-    explicit YFastTrie(BitExtractor bx = BitExtractor(), Compare cmp = Compare(), ArbitraryAllocator alloc = ArbitraryAllocator()): _alloc(alloc), _cmp(cmp), _trie(bx, cmp), _rebuilds(0), _size(0) {}
-    YFastTrie(YFastTrie&& other) noexcept: _alloc(other._alloc), _cmp(other._cmp), _trie(std::move(other._trie)), _rebuilds(other._rebuilds), _size(other._size) {
+    explicit YFastTrie(BitExtractor bx = BitExtractor(), Compare cmp = Compare(), ArbitraryAllocator alloc = ArbitraryAllocator()): _alloc(alloc), _cmp(cmp), _trie(bx, cmp, level_allocator(alloc)), _rebuilds(0), _size(0) {}
+    YFastTrie(YFastTrie&& other) noexcept: _alloc(other._alloc), _cmp(other._cmp), _trie(std::move(other._trie)), _rebuilds(other._rebuilds), _size(other._size), _thresholds(other._thresholds) {
         other._size = 0;
         other._rebuilds = 0;
     }
@@ -92,12 +109,32 @@ public:
      */
     [[nodiscard]] unsigned int rebuilds() const { return _rebuilds; }
 
+    /**
+     * @return key comparator
+     */
+    [[nodiscard]] const Compare& compare() const { return _cmp; }
+
+    /**
+     * @return allocator of the x-fast trie leaves
+     */
+    [[nodiscard]] Alloc get_allocator() const { return _alloc; }
+
+    /**
+     * @return the number of leaves above which a bucket is split
+     */
+    [[nodiscard]] unsigned int split_threshold() const { return _thresholds.split(); }
+
+    /**
+     * @return the number of leaves below which a bucket is merged with a neighbor
+     */
+    [[nodiscard]] unsigned int merge_threshold() const { return _thresholds.merge(); }
+
     /**
      * @return location of the leaf with the minimal key in the trie
      */
     Where leftmost() const {
         auto xleaf = _trie.leftmost();
-        auto leaf = xleaf != nullptr ? xleaf->value.leftmost() : nullptr;
+        auto leaf = xleaf != nullptr ? xleaf->min : nullptr;
         return { this, xleaf, leaf };
     }
 
@@ -106,7 +143,7 @@ public:
      */
     Where rightmost() const {
         auto xleaf = _trie.rightmost();
-        auto leaf = xleaf != nullptr ? xleaf->value.rightmost() : nullptr;
+        auto leaf = xleaf != nullptr ? xleaf->max : nullptr;
         return { this, xleaf, leaf };
     }
 
@@ -115,22 +152,19 @@ public:
      * @param key key to find
      * @return location of the leaf with the key equal to \a key or \a nowhere
      */
-    Where find(const Key& key) const {
-        auto pred = _trie.pred(key);
-        if (pred != nullptr) {
-            auto leaf = pred->value.find(key);
-            if (leaf != nullptr) {
-                return { this, pred, leaf };
-            }
-        }
-        auto succ = (pred != nullptr) ? pred->nxt : _trie.leftmost();
-        if (succ != nullptr) {
-            auto leaf = succ->value.find(key);
-            if (leaf != nullptr) {
-                return { this, succ, leaf };
-            }
-        }
-        return nowhere;
+    template <typename K = Key>
+    Where find(const K& key) const {
+        return find(key, _trie.pred(key));
+    }
+
+    /**
+     * find leaves with equal keys for a batch of keys; x-fast trie lookups of different keys are interleaved
+     * @param keys keys to find
+     * @param wheres output: locations of the leaves with the keys equal to \a keys or \a nowhere (same size as
+     * \a keys)
+     */
+    void find_batch(std::span<const Key> keys, std::span<Where> wheres) const {
+        batch(keys, wheres, false, false, [this] (const Key& key, XFastLeaf* xleaf) { return find(key, xleaf); });
     }
 
     /**
@@ -139,71 +173,93 @@ public:
      * @param strict whether a leaf with the key strictly less than \a key should be returned
      * @return location of the leaf with the maximal key either not greater or strictly less than \a key
      */
-    Where pred(const Key& key, bool strict = false) const {
-        auto pred = _trie.pred(key, strict);
-        if (pred != nullptr) {
-            auto pred_max = pred->value.rightmost();
-            if (_cmp(pred_max->key, key)) {
-                auto succ = pred->nxt;
-                if (succ != nullptr && !_cmp(key, succ->value.leftmost()->key)) {
-                    auto leaf = succ->value.pred(key, strict);
-                    if (leaf != nullptr) {
-                        return { this, succ, leaf };
-                    }
-                    else {
-                        return { this, pred, pred_max };
-                    }
-                }
-                else {
-                    return { this, pred, pred_max };
-                }
-            }
-            else {
-                auto leaf = pred->value.pred(key, strict);
-                return { this, pred, leaf };
-            }
+    template <typename K = Key>
+    Where pred(const K& key, bool strict = false) const {
+        return pred(key, _trie.pred(key, strict), strict);
+    }
+
+    /**
+     * find predecessor leaves for a batch of keys; x-fast trie lookups of different keys are interleaved
+     * @param keys keys
+     * @param wheres output: locations of the leaves with the maximal keys either not greater or strictly less than
+     * \a keys (same size as \a keys)
+     * @param strict whether leaves with keys strictly less than \a keys should be returned
+     */
+    void pred_batch(std::span<const Key> keys, std::span<Where> wheres, bool strict = false) const {
+        batch(keys, wheres, strict, false, [this, strict] (const Key& key, XFastLeaf* xleaf) { return pred(key, xleaf, strict); });
+    }
+
+    /**
+     * find a successor leaf for a key
+     * @param key key
+     * @param strict whether a leaf with the key strictly greater than \a key should be returned
+     * @return location of the leaf with the minimal key either not less or strictly greater than \a key
+     */
+    template <typename K = Key>
+    Where succ(const K& key, bool strict = false) const {
+        if constexpr (MIN_REPRESENTATIVES) {
+            return succ_after(key, _trie.pred(key), strict);
         }
         else {
-            auto succ = _trie.leftmost();
-            auto leaf = succ != nullptr ? succ->value.pred(key, strict) : nullptr;
-            return { this, succ, leaf };
+            return succ(key, _trie.succ(key, strict), strict);
         }
     }
 
     /**
-     * find a successor leaf for a key
+     * find successor leaves for a batch of keys; x-fast trie lookups of different keys are interleaved
+     * @param keys keys
+     * @param wheres output: locations of the leaves with the minimal keys either not less or strictly greater than
+     * \a keys (same size as \a keys)
+     * @param strict whether leaves with keys strictly greater than \a keys should be returned
+     */
+    void succ_batch(std::span<const Key> keys, std::span<Where> wheres, bool strict = false) const {
+        if constexpr (MIN_REPRESENTATIVES) {
+            batch(keys, wheres, false, false, [this, strict] (const Key& key, XFastLeaf* xleaf) { return succ_after(key, xleaf, strict); });
+        }
+        else {
+            batch(keys, wheres, strict, true, [this, strict] (const Key& key, XFastLeaf* xleaf) { return succ(key, xleaf, strict); });
+        }
+    }
+
+    /**
+     * find a leaf with an equal key starting from a nearby location
+     * @param key key to find
+     * @param hint location obtained since the last rebuild (or \a nowhere)
+     * @return location of the leaf with the key equal to \a key or \a nowhere
+     */
+    template <typename K = Key>
+    Where find_near(const K& key, const Where& hint) const {
+        return find(key, locate(key, hint.xleaf, false));
+    }
+
+    /**
+     * find a predecessor leaf for a key starting from a nearby location
      * @param key key
+     * @param hint location obtained since the last rebuild (or \a nowhere)
+     * @param strict whether a leaf with the key strictly less than \a key should be returned
+     * @return location of the leaf with the maximal key either not greater or strictly less than \a key
+     */
+    template <typename K = Key>
+    Where pred_near(const K& key, const Where& hint, bool strict = false) const {
+        return pred(key, locate(key, hint.xleaf, strict), strict);
+    }
+
+    /**
+     * find a successor leaf for a key starting from a nearby location
+     * @param key key
+     * @param hint location obtained since the last rebuild (or \a nowhere)
      * @param strict whether a leaf with the key strictly greater than \a key should be returned
      * @return location of the leaf with the minimal key either not less or strictly greater than \a key
      */
-    Where succ(const Key& key, bool strict = false) const {
-        auto succ = _trie.succ(key, strict);
-        if (succ != nullptr) {
-            auto succ_min = succ->value.leftmost();
-            if (_cmp(key, succ_min->key)) {
-                auto pred = succ->prv;
-                if (pred != nullptr && !_cmp(pred->value.rightmost()->key, key)) {
-                    auto leaf = pred->value.succ(key, strict);
-                    if (leaf != nullptr) {
-                        return { this, pred, leaf };
-                    }
-                    else {
-                        return { this, succ, succ_min };
-                    }
-                }
-                else {
-                    return { this, succ, succ_min };
-                }
-            }
-            else {
-                auto leaf = succ->value.succ(key, strict);
-                return { this, succ, leaf };
-            }
+    template <typename K = Key>
+    Where succ_near(const K& key, const Where& hint, bool strict = false) const {
+        if constexpr (MIN_REPRESENTATIVES) {
+            return succ_after(key, locate(key, hint.xleaf, false), strict);
         }
         else {
-            auto pred = _trie.rightmost();
-            auto leaf = pred != nullptr ? pred->value.succ(key, strict) : nullptr;
-            return { this, pred, leaf };
+            // the x-fast trie successor follows the predecessor of the opposite strictness
+            auto pred = locate(key, hint.xleaf, !strict);
+            return succ(key, pred != nullptr ? pred->nxt : _trie.leftmost(), strict);
         }
     }
 
@@ -221,7 +277,7 @@ public:
         XFastLeaf* xleaf;
 
         if (pred != nullptr && succ != nullptr) {
-            if (_cmp(leaf->key, succ->value.leftmost()->key)) {
+            if (MIN_REPRESENTATIVES || _cmp(leaf->key, succ->min->key)) {
                 xleaf = pred;
             }
             else {
@@ -240,16 +296,16 @@ public:
             _trie.insert(xleaf);
         }
 
-        auto replaced = xleaf->value.insert(leaf);
+        auto replaced = bucket_insert(xleaf, leaf);
 
         if (replaced == nullptr) {
-            if (xleaf->value.size() > TREE_SPLIT_THRESHOLD) {
+            if (xleaf->value.size() > _thresholds.split()) {
                 _trie.remove(xleaf);
                 auto split_result = xleaf->value.split();
                 XFastLeaf* left = std::allocator_traits<Alloc>::allocate(_alloc, 1);
-                std::allocator_traits<Alloc>::construct(_alloc, left, split_result.left.root()->key, std::move(split_result.left));
+                std::allocator_traits<Alloc>::construct(_alloc, left, representative(split_result.left), std::move(split_result.left));
                 XFastLeaf* right = std::allocator_traits<Alloc>::allocate(_alloc, 1);
-                std::allocator_traits<Alloc>::construct(_alloc, right, split_result.right.root()->key, std::move(split_result.right));
+                std::allocator_traits<Alloc>::construct(_alloc, right, representative(split_result.right), std::move(split_result.right));
                 _trie.insert(left);
                 _trie.insert(right);
                 std::allocator_traits<Alloc>::destroy(_alloc, xleaf);
@@ -259,6 +315,7 @@ public:
             }
             ++_size;
         }
+        on_update();
 
         return { this, xleaf, replaced };
     }
@@ -277,25 +334,32 @@ public:
         if (xleaf == nullptr) {
             return;
         }
-        xleaf->value.remove(leaf);
-        if (xleaf->value.size() < TREE_MERGE_THRESHOLD) {
+        bucket_remove(xleaf, leaf);
+        if (xleaf->value.size() == 0) {
+            // an empty bucket is dropped rather than merged, whatever the merge threshold
+            _trie.remove(xleaf);
+            std::allocator_traits<Alloc>::destroy(_alloc, xleaf);
+            std::allocator_traits<Alloc>::deallocate(_alloc, xleaf, 1);
+            ++_rebuilds;
+        }
+        else if (xleaf->value.size() < _thresholds.merge()) {
             auto neighbor = pick_neighbor(xleaf);
             if (neighbor != nullptr) {
                 _trie.remove(xleaf);
                 _trie.remove(neighbor);
                 auto merged = Value::merge(std::move(xleaf->value), std::move(neighbor->value));
-                if (merged.size() > TREE_SPLIT_THRESHOLD) {
+                if (merged.size() > _thresholds.split()) {
                     auto split_result = merged.split();
                     XFastLeaf* left = std::allocator_traits<Alloc>::allocate(_alloc, 1);
-                    std::allocator_traits<Alloc>::construct(_alloc, left, split_result.left.root()->key, std::move(split_result.left));
+                    std::allocator_traits<Alloc>::construct(_alloc, left, representative(split_result.left), std::move(split_result.left));
                     XFastLeaf* right = std::allocator_traits<Alloc>::allocate(_alloc, 1);
-                    std::allocator_traits<Alloc>::construct(_alloc, right, split_result.right.root()->key, std::move(split_result.right));
+                    std::allocator_traits<Alloc>::construct(_alloc, right, representative(split_result.right), std::move(split_result.right));
                     _trie.insert(left);
                     _trie.insert(right);
                 }
                 else {
                     XFastLeaf* merged_xleaf = std::allocator_traits<Alloc>::allocate(_alloc, 1);
-                    std::allocator_traits<Alloc>::construct(_alloc, merged_xleaf, merged.root()->key, std::move(merged));
+                    std::allocator_traits<Alloc>::construct(_alloc, merged_xleaf, representative(merged), std::move(merged));
                     _trie.insert(merged_xleaf);
                 }
                 std::allocator_traits<Alloc>::destroy(_alloc, xleaf);
@@ -304,57 +368,362 @@ public:
                 std::allocator_traits<Alloc>::deallocate(_alloc, neighbor, 1);
                 ++_rebuilds;
             }
-            else if (xleaf->value.size() == 0) {
-                _trie.remove(xleaf);
-                std::allocator_traits<Alloc>::destroy(_alloc, xleaf);
-                std::allocator_traits<Alloc>::deallocate(_alloc, xleaf, 1);
-                ++_rebuilds;
-            }
-        }
-        else {
-            if (_cmp(xleaf->key, xleaf->value.leftmost()->key) || _cmp(xleaf->value.rightmost()->key, xleaf->key)) {
-                _trie.remove(xleaf);
-                XFastLeaf* reinserted_xleaf = std::allocator_traits<Alloc>::allocate(_alloc, 1);
-                std::allocator_traits<Alloc>::construct(_alloc, reinserted_xleaf, xleaf->value.root()->key, std::move(xleaf->value));
-                _trie.insert(reinserted_xleaf);
-                std::allocator_traits<Alloc>::destroy(_alloc, xleaf);
-                std::allocator_traits<Alloc>::deallocate(_alloc, xleaf, 1);
-            }
         }
+        // a representative left out of its bucket range is kept: removal only narrows the range, so buckets stay
+        // between the neighboring representatives, which is all lookups rely on
 
         --_size;
+        on_update();
     }
 
     /**
-     * remove all the internal nodes; leaves are neither deallocated nor destroyed
+     * allocate room in the underlying x-fast trie to avoid rehashing while growing
+     * @param n expected number of leaves
      */
-    void clear() {
-        auto xleaf = _trie.leftmost();
-        while (xleaf != nullptr) {
-            auto nxt = xleaf->nxt;
+    void reserve(std::size_t n) {
+        _trie.reserve(2 * n / _thresholds.split() + 1);  // split buckets hold about half the split threshold
+    }
+
+    /**
+     * @return number of leaves to build buckets of with \a append(), i.e. half the split threshold (the size buckets
+     * are split into)
+     */
+    [[nodiscard]] std::size_t append_size() const { return std::max(_thresholds.split() / 2, 1U); }
+
+    /**
+     * append a bucket of leaves at once, built balanced in linear time and inserted with a single x-fast trie update,
+     * so that filling a trie bucket by bucket takes O(n + nH/bucket) rather than n inserts
+     * @param leaves at most \a append_size() leaves (not to be split) with strictly ascending keys, all greater than the
+     * keys in the trie
+     * @throw std::bad_alloc if the bucket cannot be allocated or inserted; \a leaves are left to the caller and the
+     * level tables may be left inconsistent, so the trie must be cleared
+     */
+    void append(std::span<Leaf* const> leaves) {
+        if (leaves.empty()) {
+            return;
+        }
+        auto value = Value::build(leaves, _cmp);
+        XFastLeaf* xleaf = std::allocator_traits<Alloc>::allocate(_alloc, 1);
+        std::allocator_traits<Alloc>::construct(_alloc, xleaf, representative(value), std::move(value));
+        try {
+            _trie.insert(xleaf);
+        }
+        catch (...) {
+            // the bucket may be linked after the last one already, which clear() walks from
+            if (xleaf->prv != nullptr && xleaf->prv->nxt == xleaf) {
+                xleaf->prv->nxt = nullptr;
+            }
             std::allocator_traits<Alloc>::destroy(_alloc, xleaf);
             std::allocator_traits<Alloc>::deallocate(_alloc, xleaf, 1);
-            xleaf = nxt;
+            throw;
+        }
+        _size += leaves.size();
+        ++_rebuilds;
+    }
+
+    /**
+     * remove all the internal nodes; leaves are neither deallocated nor destroyed \n
+     * with an arena allocator (see \a yfast::utils::ArenaAllocator) internal nodes are not deallocated (nor even
+     * visited, if trivially destructible) either, but left for the owner of the leaves to release along with them
+     */
+    void clear() {
+        if constexpr (!internal::ArenaAllocatorGeneric<Alloc> || !std::is_trivially_destructible_v<XFastLeaf>) {
+            auto xleaf = _trie.leftmost();
+            while (xleaf != nullptr) {
+                auto nxt = xleaf->nxt;
+                std::allocator_traits<Alloc>::destroy(_alloc, xleaf);
+                if constexpr (!internal::ArenaAllocatorGeneric<Alloc>) {
+                    std::allocator_traits<Alloc>::deallocate(_alloc, xleaf, 1);
+                }
+                xleaf = nxt;
+            }
         }
         _trie.clear();
         _size = 0;
-        _rebuilds = 0;
+        ++_rebuilds;  // x-fast trie leaves held by outstanding locations are gone
     }
 
 private:
-    static XFastLeaf* pick_neighbor(XFastLeaf* xleaf) {
+    static LevelAlloc level_allocator(const ArbitraryAllocator& alloc) {
+        if constexpr (std::is_same_v<LevelAlloc, ArbitraryAllocator>) {
+            return alloc;
+        }
+        else {
+            return LevelAlloc();
+        }
+    }
+
+    /**
+     * @param pred x-fast trie predecessor of \a key
+     */
+    template <typename K = Key>
+    Where find(const K& key, XFastLeaf* pred) const {
+        if constexpr (MIN_REPRESENTATIVES) {
+            auto xleaf = pred != nullptr ? pred : _trie.leftmost();
+            auto leaf = xleaf != nullptr ? xleaf->value.find(key) : nullptr;
+            return leaf != nullptr ? Where { this, xleaf, leaf } : nowhere;
+        }
+        if (pred != nullptr) {
+            auto leaf = pred->value.find(key);
+            if (leaf != nullptr) {
+                return { this, pred, leaf };
+            }
+        }
+        auto succ = (pred != nullptr) ? pred->nxt : _trie.leftmost();
+        if (succ != nullptr) {
+            auto leaf = succ->value.find(key);
+            if (leaf != nullptr) {
+                return { this, succ, leaf };
+            }
+        }
+        return nowhere;
+    }
+
+    /**
+     * @param pred x-fast trie predecessor of \a key
+     */
+    template <typename K = Key>
+    Where pred(const K& key, XFastLeaf* pred, bool strict) const {
+        if constexpr (MIN_REPRESENTATIVES) {
+            auto xleaf = pred != nullptr ? pred : _trie.leftmost();
+            if (xleaf == nullptr) {
+                return nowhere;
+            }
+            auto leaf = xleaf->value.pred(key, strict);
+            if (leaf == nullptr && xleaf->prv != nullptr) {
+                // the bucket minimum has been removed since the bucket got its representative
+                return { this, xleaf->prv, xleaf->prv->max };
+            }
+            return { this, xleaf, leaf };
+        }
+        if (pred != nullptr) {
+            auto pred_max = pred->max;
+            if (_cmp(pred_max->key, key)) {
+                auto succ = pred->nxt;
+                if (succ != nullptr && !_cmp(key, succ->min->key)) {
+                    auto leaf = succ->value.pred(key, strict);
+                    if (leaf != nullptr) {
+                        return { this, succ, leaf };
+                    }
+                    else {
+                        return { this, pred, pred_max };
+                    }
+                }
+                else {
+                    return { this, pred, pred_max };
+                }
+            }
+            else {
+                auto leaf = pred->value.pred(key, strict);
+                if (leaf == nullptr && pred->prv != nullptr) {
+                    // the representative is below the bucket range, and so is the key
+                    return { this, pred->prv, pred->prv->max };
+                }
+                return { this, pred, leaf };
+            }
+        }
+        else {
+            auto succ = _trie.leftmost();
+            auto leaf = succ != nullptr ? succ->value.pred(key, strict) : nullptr;
+            return { this, succ, leaf };
+        }
+    }
+
+    /**
+     * @param succ x-fast trie successor of \a key
+     */
+    template <typename K = Key>
+    Where succ(const K& key, XFastLeaf* succ, bool strict) const {
+        if (succ != nullptr) {
+            auto succ_min = succ->min;
+            if (_cmp(key, succ_min->key)) {
+                auto pred = succ->prv;
+                if (pred != nullptr && !_cmp(pred->max->key, key)) {
+                    auto leaf = pred->value.succ(key, strict);
+                    if (leaf != nullptr) {
+                        return { this, pred, leaf };
+                    }
+                    else {
+                        return { this, succ, succ_min };
+                    }
+                }
+                else {
+                    return { this, succ, succ_min };
+                }
+            }
+            else {
+                auto leaf = succ->value.succ(key, strict);
+                if (leaf == nullptr && succ->nxt != nullptr) {
+                    // the representative is above the bucket range, and so is the key
+                    return { this, succ->nxt, succ->nxt->min };
+                }
+                return { this, succ, leaf };
+            }
+        }
+        else {
+            auto pred = _trie.rightmost();
+            auto leaf = pred != nullptr ? pred->value.succ(key, strict) : nullptr;
+            return { this, pred, leaf };
+        }
+    }
+
+    /**
+     * successor lookup for minimum representatives: the successor is either in the predecessor bucket or is the
+     * minimum of the next one
+     * @param pred x-fast trie predecessor of \a key (not strict)
+     */
+    template <typename K = Key>
+    Where succ_after(const K& key, XFastLeaf* pred, bool strict) const {
+        auto xleaf = pred != nullptr ? pred : _trie.leftmost();
+        if (xleaf == nullptr) {
+            return nowhere;
+        }
+        auto leaf = xleaf->value.succ(key, strict);
+        if (leaf == nullptr && xleaf->nxt != nullptr) {
+            return { this, xleaf->nxt, xleaf->nxt->min };
+        }
+        return leaf != nullptr ? Where { this, xleaf, leaf } : nowhere;
+    }
+
+    /**
+     * x-fast trie predecessor of a key found by walking at most \a FINGER_STEPS buckets from \a hint; falls back to
+     * the x-fast trie lookup if the key is farther away
+     * @param hint x-fast trie leaf to start from or \a nullptr
+     * @param strict whether the representative key must be strictly less than \a key
+     */
+    template <typename K = Key>
+    XFastLeaf* locate(const K& key, XFastLeaf* hint, bool strict) const {
+        auto before = [&] (const XFastLeaf* xleaf) { return strict ? _cmp(xleaf->key, key) : !_cmp(key, xleaf->key); };
+        if (hint != nullptr) {
+            if (before(hint)) {
+                for (unsigned int step = 0; step < FINGER_STEPS; ++step) {
+                    auto nxt = hint->nxt;
+                    if (nxt == nullptr || !before(nxt)) {
+                        return hint;
+                    }
+                    hint = nxt;
+                }
+            }
+            else {
+                for (unsigned int step = 0; step < FINGER_STEPS; ++step) {
+                    auto prv = hint->prv;
+                    if (prv == nullptr || before(prv)) {
+                        return prv;
+                    }
+                    hint = prv;
+                }
+            }
+        }
+        return _trie.pred(key, strict);
+    }
+
+    /**
+     * resolve a batch of keys against buckets found by a batch x-fast trie lookup; every bucket is prefetched before
+     * any of them is searched
+     * @param succ whether buckets are found by successor (rather than predecessor) lookup
+     * @param strict whether x-fast trie lookups are strict
+     * @param resolve callable taking a key and its x-fast trie leaf; returns \a Where
+     */
+    template <typename Resolve>
+    void batch(std::span<const Key> keys, std::span<Where> wheres, bool strict, bool succ, Resolve&& resolve) const {
+        constexpr auto BATCH_WIDTH = decltype(_trie)::BATCH_WIDTH;
+        XFastLeaf* xleaves[BATCH_WIDTH];
+        for (std::size_t i = 0; i < keys.size(); i += BATCH_WIDTH) {
+            const auto count = std::min(BATCH_WIDTH, keys.size() - i);
+            if (succ) {
+                _trie.succ_batch(keys.subspan(i, count), std::span(xleaves, count), strict);
+            }
+            else {
+                _trie.pred_batch(keys.subspan(i, count), std::span(xleaves, count), strict);
+            }
+            for (std::size_t j = 0; j < count; ++j) {
+                if (xleaves[j] != nullptr) {
+                    if constexpr (requires { xleaves[j]->value.prefetch(); }) {
+                        xleaves[j]->value.prefetch();
+                    }
+                    else {
+                        utils::prefetch(xleaves[j]->value.root());
+                    }
+                }
+            }
+            for (std::size_t j = 0; j < count; ++j) {
+                wheres[i + j] = resolve(keys[i + j], xleaves[j]);
+            }
+        }
+    }
+
+    /**
+     * insert a leaf into a bucket keeping the bucket extremes
+     * @return leaf being replaced or \a nullptr
+     */
+    Leaf* bucket_insert(XFastLeaf* xleaf, Leaf* leaf) {
+        auto replaced = xleaf->value.insert(leaf);
+        if (replaced != nullptr) {
+            if (xleaf->min == replaced) {
+                xleaf->min = leaf;
+            }
+            if (xleaf->max == replaced) {
+                xleaf->max = leaf;
+            }
+        }
+        else {
+            if (xleaf->min == nullptr || _cmp(leaf->key, xleaf->min->key)) {
+                xleaf->min = leaf;
+            }
+            if (xleaf->max == nullptr || _cmp(xleaf->max->key, leaf->key)) {
+                xleaf->max = leaf;
+            }
+        }
+        return replaced;
+    }
+
+    /**
+     * remove a leaf from a bucket keeping the bucket extremes; only removing an extreme takes a bucket walk
+     */
+    static void bucket_remove(XFastLeaf* xleaf, Leaf* leaf) {
+        xleaf->value.remove(leaf);
+        if (xleaf->min == leaf) {
+            xleaf->min = xleaf->value.leftmost();
+        }
+        if (xleaf->max == leaf) {
+            xleaf->max = xleaf->value.rightmost();
+        }
+    }
+
+    /**
+     * @return key to represent a bucket with in the x-fast trie
+     */
+    static const Key& representative(const Value& value) {
+        if constexpr (MIN_REPRESENTATIVES) {
+            return value.leftmost()->key;
+        }
+        else {
+            return value.root()->key;
+        }
+    }
+
+    /**
+     * let adaptive thresholds (if any) observe an update along with the rebuilds it has taken
+     */
+    void on_update() {
+        if constexpr (requires { _thresholds.on_update(_rebuilds, _size); }) {
+            _thresholds.on_update(_rebuilds, _size);
+        }
+    }
+
+    XFastLeaf* pick_neighbor(XFastLeaf* xleaf) const {
         auto pred = xleaf->prv;
         auto succ = xleaf->nxt;
         if (pred != nullptr && succ != nullptr) {
             auto pred_merge_size = pred->value.size() + xleaf->value.size();
             auto succ_merge_size = succ->value.size() + xleaf->value.size();
-            if (pred_merge_size <= TREE_SPLIT_THRESHOLD && succ_merge_size <= TREE_SPLIT_THRESHOLD) {
+            if (pred_merge_size <= _thresholds.split() && succ_merge_size <= _thresholds.split()) {
                 return pred_merge_size < succ_merge_size ? pred : succ;
             }
-            if (pred_merge_size <= TREE_SPLIT_THRESHOLD) {
+            if (pred_merge_size <= _thresholds.split()) {
                 return pred;
             }
-            if (succ_merge_size <= TREE_SPLIT_THRESHOLD) {
+            if (succ_merge_size <= _thresholds.split()) {
                 return succ;
             }
             return pred_merge_size > succ_merge_size ? pred : succ;
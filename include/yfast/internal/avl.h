@@ -5,14 +5,14 @@
 
 namespace yfast::internal {
 
-template <typename Key, typename T>
-struct AVLNodeBase: public BSTNodeBase<Key, T> {
-    using typename BSTNodeBase<Key, T>::Child;
+template <typename Key, typename T, typename NodeBase = BSTNodeBase<Key, T>>
+struct AVLNodeBase: public NodeBase {
+    using typename NodeBase::Child;
 
-    using BSTNodeBase<Key, T>::_left;
-    using BSTNodeBase<Key, T>::_right;
+    using NodeBase::_left;
+    using NodeBase::_right;
 
-    explicit AVLNodeBase(const Key& key): BSTNodeBase<Key, T>(key) {}
+    explicit AVLNodeBase(const Key& key): NodeBase(key) {}
 
     [[nodiscard]] bool is_left_heavy() const { return Child(_left).get_bit(0); }
     [[nodiscard]] bool is_right_heavy() const { return Child(_right).get_bit(0); }
@@ -47,6 +47,25 @@ struct AVLNodeBase: public BSTNodeBase<Key, T> {
     }
 };
 
+/**
+ * \a Layout template parameter of leaves: nodes linked by pointers, each storing its subtree size
+ */
+struct PointerLayout {
+    template <typename Key, typename T>
+    using NodeBase = AVLNodeBase<Key, T>;
+};
+
+/**
+ * \a Layout template parameter of leaves: nodes linked by 32-bit \a yfast::utils::NodePool indices (see
+ * \a CompactBSTNodeBase), e.g. 16 rather than 40 bytes per node for 32-bit keys without values
+ * @tparam SubtreeSizes whether nodes store their subtree sizes (not needed by buckets, which count their nodes)
+ */
+template <bool SubtreeSizes = false>
+struct CompactLayout {
+    template <typename Key, typename T>
+    using NodeBase = AVLNodeBase<Key, T, CompactBSTNodeBase<Key, T, SubtreeSizes>>;
+};
+
 }
 
 #endif
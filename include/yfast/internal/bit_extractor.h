@@ -1,27 +1,200 @@
 #ifndef _YFAST_INTERNAL_BIT_EXTRACTOR_H
 #define _YFAST_INTERNAL_BIT_EXTRACTOR_H
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
 #include <string>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
+#include <yfast/internal/fixed_words.h>
 #include <yfast/internal/hash.h>
+#include <yfast/internal/hashed_prefix.h>
+#include <yfast/internal/inline_bytes.h>
+#include <yfast/internal/integral.h>
 
 namespace yfast::internal {
 
 template <typename Key, typename = void>
 class BitExtractor;
 
+// n < H <= 8 * sizeof(Key), so neither shift overflows even for 64- and 128-bit keys
 template <typename Key>
-class BitExtractor<Key, std::enable_if_t<std::is_integral_v<Key>>> {
+class BitExtractor<Key, std::enable_if_t<is_integral_v<Key> && !is_signed_v<Key>>> {
 public:
     typedef Key ShiftResult;
 
-    static bool extract_bit(Key key, unsigned int n) { return key & (1 << n); }
+    static bool extract_bit(Key key, unsigned int n) { return (key >> n) & 1; }
     static Key shift(Key key, unsigned int n) { return key >> n; }
 };
 
+/**
+ * shifts of a single key read (and converted to an unsigned number) once
+ * @tparam Number unsigned number type
+ */
+template <typename Number>
+class NumberShifts {
+    Number _number;
+
+public:
+    NumberShifts() = default;
+    explicit NumberShifts(const Number& number): _number(number) {}
+
+    Number operator () (unsigned int n) const { return _number >> n; }
+};
+
+/**
+ * order-preserving bijection of keys onto unsigned integers of the same width
+ */
+template <typename Key, typename = void>
+struct OrderedBits;
+
+// flipping the sign bit moves negative keys below non-negative ones
+template <typename Key>
+struct OrderedBits<Key, std::enable_if_t<is_signed_v<Key>>> {
+    typedef make_unsigned_t<Key> Type;
+
+    static Type map(Key key) {
+        return static_cast<Type>(key) ^ (Type{1} << (8 * sizeof(Key) - 1));
+    }
+};
+
+// IEEE-754 total order: negative numbers get all their bits flipped, the others just the sign bit; negative zero is
+// folded into zero since std::less has them equal (NaNs are not supported, as by std::less)
+template <typename Key>
+struct OrderedBits<Key, std::enable_if_t<std::is_floating_point_v<Key>>> {
+    static_assert(std::numeric_limits<Key>::is_iec559 && (sizeof(Key) == sizeof(std::uint32_t) || sizeof(Key) == sizeof(std::uint64_t)), "IEEE-754 single or double precision required");
+
+    typedef std::conditional_t<sizeof(Key) == sizeof(std::uint32_t), std::uint32_t, std::uint64_t> Type;
+
+    static Type map(Key key) {
+        const auto bits = std::bit_cast<Type>(key == 0 ? Key(0) : key);
+        constexpr auto sign_shift = 8 * sizeof(Type) - 1;
+        return bits ^ (static_cast<Type>(-(bits >> sign_shift)) | (Type{1} << sign_shift));
+    }
+};
+
+/**
+ * bit extractor for signed integral and floating point keys: keys are mapped by \a OrderedBits, so that the bit
+ * order agrees with \a std::less; a lookup maps its key only once (see \a prefixes())
+ */
+template <typename Key>
+class BitExtractor<Key, std::void_t<typename OrderedBits<Key>::Type>> {
+    typedef OrderedBits<Key> Bits;
+
+public:
+    typedef typename Bits::Type ShiftResult;
+    typedef NumberShifts<ShiftResult> Prefixes;
+
+    static bool extract_bit(Key key, unsigned int n) { return (Bits::map(key) >> n) & 1; }
+    static ShiftResult shift(Key key, unsigned int n) { return Bits::map(key) >> n; }
+    static Prefixes prefixes(Key key) { return Prefixes(Bits::map(key)); }
+};
+
+/**
+ * bit extractor for trivially copyable keys whose object representation is a big-endian number (e.g. a UUID): keys
+ * are shifted as \a std::uint64_t, \a UInt128 or \a FixedWords with word arithmetic, so shifted keys are trivially
+ * copyable and hashable and take no allocation; a lookup reads its key only once (see \a prefixes())
+ * @tparam Key key type
+ */
+template <typename Key>
+class FixedWidthBitExtractor {
+    static_assert(std::is_trivially_copyable_v<Key>, "Trivially copyable key required");
+
+    static constexpr std::size_t N = sizeof(Key);
+
+public:
+    typedef typename FixedWidthNumber<N>::Type ShiftResult;
+    typedef NumberShifts<ShiftResult> Prefixes;
+
+    static bool extract_bit(const Key& key, unsigned int n) {
+        const auto data = reinterpret_cast<const std::byte*>(&key);
+        return (data[N - 1 - n / 8] & (std::byte{1} << (n % 8))) != std::byte{0};
+    }
+
+    static ShiftResult shift(const Key& key, unsigned int n) {
+        return load_big_endian<N>(reinterpret_cast<const std::byte*>(&key)) >> n;
+    }
+
+    static Prefixes prefixes(const Key& key) {
+        return Prefixes(load_big_endian<N>(reinterpret_cast<const std::byte*>(&key)));
+    }
+};
+
+template <std::size_t N>
+class BitExtractor<std::array<std::byte, N>>: public FixedWidthBitExtractor<std::array<std::byte, N>> {};
+
+/**
+ * bit extractor for \a std::pair or \a std::tuple keys of integral fields: fields are concatenated into a single
+ * unsigned number of \a KeyLength bits (the first field taking the most significant bits), so that the bit order
+ * agrees with lexicographic \a std::less and a range of keys sharing leading fields is a subtree \n
+ * a field of width \a w must fit into \a w bits: an unsigned one must be less than 2^w, a signed one must be within
+ * [-2^(w-1), 2^(w-1)) and gets biased by 2^(w-1)
+ * @tparam Key \a std::pair or \a std::tuple of integral types
+ * @tparam Widths field widths in bits
+ */
+template <typename Key, unsigned int... Widths>
+class CompositeBitExtractor {
+    static_assert(sizeof...(Widths) == std::tuple_size_v<Key>, "A width per field required");
+
+public:
+    /**
+     * key length in bits, i.e. \a H to be used with this extractor
+     */
+    static constexpr unsigned int KeyLength = (Widths + ...);
+
+    typedef typename FixedWidthNumber<(KeyLength + 7) / 8>::Type ShiftResult;
+    typedef NumberShifts<ShiftResult> Prefixes;
+
+    static_assert(is_integral_v<ShiftResult>, "Composite key too long");
+
+    static bool extract_bit(const Key& key, unsigned int n) { return (pack(key) >> n) & 1; }
+    static ShiftResult shift(const Key& key, unsigned int n) { return pack(key) >> n; }
+    static Prefixes prefixes(const Key& key) { return Prefixes(pack(key)); }
+
+    static ShiftResult pack(const Key& key) {
+        return pack(key, std::make_index_sequence<sizeof...(Widths)>());
+    }
+
+private:
+    template <std::size_t... I>
+    static ShiftResult pack(const Key& key, std::index_sequence<I...>) {
+        ShiftResult number = 0;
+        ((number = shift_left<Widths>(number) | field<Widths>(std::get<I>(key))), ...);
+        return number;
+    }
+
+    template <unsigned int W>
+    static ShiftResult shift_left(ShiftResult number) {
+        if constexpr (W < 8 * sizeof(ShiftResult)) {
+            return number << W;
+        }
+        else {
+            return 0;  // a single field taking the whole number
+        }
+    }
+
+    template <unsigned int W, typename Field>
+    static ShiftResult field(Field value) {
+        static_assert(is_integral_v<Field>, "Integral field required");
+        static_assert(W > 0 && W <= 8 * sizeof(Field), "Field width out of range");
+        constexpr auto mask = static_cast<make_unsigned_t<Field>>(~make_unsigned_t<Field>{0} >> (8 * sizeof(Field) - W));
+        auto bits = static_cast<make_unsigned_t<Field>>(value);
+        if constexpr (is_signed_v<Field>) {
+            bits ^= make_unsigned_t<Field>{1} << (W - 1);  // two's complement + 2^(W-1) modulo 2^W
+        }
+        return static_cast<ShiftResult>(bits & mask);
+    }
+};
+
 template <>
 class BitExtractor<std::vector<std::byte>> {
 public:
@@ -41,27 +214,38 @@ public:
         return extract_bit(key.data(), key.size(), n);
     }
 
-    // [l | r] [l | r] [l | r]
-    // [l] [r | l] [r | l]
-    static std::vector<std::byte> shift(const std::byte* data, std::size_t size, unsigned int n) {
+    /**
+     * @return the length of a byte string of length \a size shifted by \a n bits
+     */
+    static std::size_t shifted_size(std::size_t size, unsigned int n) {
         const auto s = n / 8;
-        if (size <= s) {
-            return {};
-        }
+        return size > s ? size - s : 0;
+    }
 
-        const auto shifted_size = size - s;
-        std::vector<std::byte> shifted(shifted_size);
+    // [l | r] [l | r] [l | r]
+    // [l] [r | l] [r | l]
+    /**
+     * shift a byte string into a preallocated buffer
+     * @param shifted output: room for \a shifted_size(size, n) bytes
+     */
+    static void shift(const std::byte* data, std::size_t size, unsigned int n, std::byte* shifted) {
+        const auto count = shifted_size(size, n);
         const auto r = n % 8;
         if (r == 0) {
-            std::ranges::copy(data, data + shifted_size, shifted.begin());
-            return shifted;
+            std::copy(data, data + count, shifted);
+            return;
         }
 
         const auto l = 8 - r;
-        std::transform(data, data + shifted_size, shifted.begin(), [r] (std::byte b) { return b >> r; });
-        for (int i = 1; i < shifted_size; ++i) {
+        std::transform(data, data + count, shifted, [r] (std::byte b) { return b >> r; });
+        for (int i = 1; i < count; ++i) {
             shifted[i] |= data[i - 1] << l;
         }
+    }
+
+    static std::vector<std::byte> shift(const std::byte* data, std::size_t size, unsigned int n) {
+        std::vector<std::byte> shifted(shifted_size(size, n));
+        shift(data, size, n, shifted.data());
         return shifted;
     }
 
@@ -70,22 +254,121 @@ public:
     }
 };
 
+// takes \a std::string_view so that lookups by \a std::string_view or \a const char* construct no \a std::string
 template <>
 class BitExtractor<std::string> {
 public:
     typedef std::vector<std::byte> ShiftResult;
 
-    static bool extract_bit(const std::string& key, unsigned int n) {
+    static bool extract_bit(std::string_view key, unsigned int n) {
         const auto data = reinterpret_cast<const std::byte*>(key.data());
         return BitExtractor<std::vector<std::byte>>::extract_bit(data, key.size(), n);
     }
 
-    static std::vector<std::byte> shift(const std::string& key, unsigned int n) {
+    static std::vector<std::byte> shift(std::string_view key, unsigned int n) {
         const auto data = reinterpret_cast<const std::byte*>(key.data());
         return BitExtractor<std::vector<std::byte>>::shift(data, key.size(), n);
     }
 };
 
+/**
+ * view a byte string key is read through by \a InlineBitExtractor and \a HashedBitExtractor: \a std::string_view for
+ * \a std::string keys (so that they can be looked up by \a std::string_view or \a const char*), \a std::span otherwise
+ */
+template <typename Key>
+struct ByteView {
+    typedef std::span<const std::byte> Type;
+};
+
+template <>
+struct ByteView<std::string> {
+    typedef std::string_view Type;
+};
+
+/**
+ * bit extractor for byte string keys of bounded length: shifted keys are stored inline, so neither lookups nor
+ * updates allocate
+ * @tparam Key \a std::string or \a std::vector<std::byte> (treated the same way as by \a BitExtractor)
+ * @tparam N maximal key length in bytes (normally \a H / 8); \a std::length_error is thrown for longer keys
+ */
+template <typename Key, std::size_t N>
+class InlineBitExtractor {
+    typedef BitExtractor<std::vector<std::byte>> Bytes;
+    typedef typename ByteView<Key>::Type KeyView;
+
+public:
+    typedef InlineBytes<N> ShiftResult;
+
+    static bool extract_bit(KeyView key, unsigned int n) {
+        return Bytes::extract_bit(reinterpret_cast<const std::byte*>(key.data()), key.size(), n);
+    }
+
+    static ShiftResult shift(KeyView key, unsigned int n) {
+        const auto data = reinterpret_cast<const std::byte*>(key.data());
+        ShiftResult shifted(Bytes::shifted_size(key.size(), n));
+        Bytes::shift(data, key.size(), n, shifted.data());
+        return shifted;
+    }
+};
+
+/**
+ * bit extractor for byte string keys of bounded length: a lookup hashes the key once and then makes every shifted
+ * key it probes in constant time (see \a HashedPrefix), i.e. a lookup takes O(len + log H) rather than
+ * O(len * log H); shifted keys are views into the key unless copied into a level table
+ * @tparam Key \a std::string or \a std::vector<std::byte> (treated the same way as by \a BitExtractor)
+ * @tparam N maximal key length in bytes (normally \a H / 8); \a std::length_error is thrown for longer keys
+ */
+template <typename Key, std::size_t N>
+class HashedBitExtractor {
+    typedef typename ByteView<Key>::Type KeyView;
+
+public:
+    typedef HashedPrefix ShiftResult;
+    typedef HashedPrefixes<N> Prefixes;
+
+    static bool extract_bit(KeyView key, unsigned int n) {
+        return BitExtractor<std::vector<std::byte>>::extract_bit(reinterpret_cast<const std::byte*>(key.data()), key.size(), n);
+    }
+
+    static ShiftResult shift(KeyView key, unsigned int n) {
+        return prefixes(key)(n);
+    }
+
+    static Prefixes prefixes(KeyView key) {
+        return Prefixes(reinterpret_cast<const std::byte*>(key.data()), key.size());
+    }
+};
+
+/**
+ * shifts of a single key made by a \a shift() call each
+ */
+template <typename BitExtractor, typename Key>
+class KeyShifts {
+    const BitExtractor* _bx = nullptr;
+    const Key* _key = nullptr;
+
+public:
+    KeyShifts() = default;
+    KeyShifts(const BitExtractor& bx, const Key& key): _bx(&bx), _key(&key) {}
+
+    typename BitExtractor::ShiftResult operator () (unsigned int n) const { return _bx->shift(*_key, n); }
+};
+
+/**
+ * all the shifts of a single key, e.g. the levels a single lookup probes
+ * @return \a bx.prefixes(key) if \a BitExtractor provides it (to share work between the shifts); \a KeyShifts
+ * otherwise
+ */
+template <typename BitExtractor, typename Key>
+auto key_shifts(const BitExtractor& bx, const Key& key) {
+    if constexpr (requires { bx.prefixes(key); }) {
+        return bx.prefixes(key);
+    }
+    else {
+        return KeyShifts<BitExtractor, Key>(bx, key);
+    }
+}
+
 }
 
 #endif
@@ -2,8 +2,10 @@
 #define _YFAST_INTERNAL_BST_H
 
 #include <cstddef>
+#include <cstdint>
 
 #include <yfast/utils/aligned.h>
+#include <yfast/utils/node_pool.h>
 
 namespace yfast::internal {
 
@@ -13,14 +15,16 @@ struct BSTNodeBase {
     typedef utils::aligned_ptr<1, T> Child;
 
     const Key key;
-    T* parent;
+    T* _parent;
     std::uintptr_t _left;
     std::uintptr_t _right;
     std::size_t size;
 
+    T* parent() const { return _parent; }
     T* left() const { return Child(_left).get_ptr(); }
     T* right() const { return Child(_right).get_ptr(); }
 
+    void set_parent(T* node) { _parent = node; }
     void set_left(T* node) {
         Child child = _left;
         child.set_ptr(node);
@@ -33,6 +37,51 @@ struct BSTNodeBase {
     }
 };
 
+/**
+ * \a BSTNodeBase counterpart linking nodes by 32-bit \a yfast::utils::NodePool indices rather than by pointers, so
+ * nodes must be allocated with \a Allocator; subtree sizes are not stored, trees of such nodes count them instead
+ * (see \a CompactBSTNodeBase<Key, T, true>)
+ */
+template <typename _Key, typename T, bool SubtreeSizes = false>
+struct CompactBSTNodeBase {
+    typedef _Key Key;
+    typedef utils::pool_ptr<1, T> Child;
+    typedef utils::NodePoolAllocator<T> Allocator;
+
+    const Key key;
+    std::uint32_t _parent;
+    std::uint32_t _left;
+    std::uint32_t _right;
+
+    explicit CompactBSTNodeBase(const Key& key): key(key), _parent(0), _left(0), _right(0) {}
+
+    T* parent() const { return utils::pool_ptr<0, T>(_parent).get_ptr(); }
+    T* left() const { return Child(_left).get_ptr(); }
+    T* right() const { return Child(_right).get_ptr(); }
+
+    void set_parent(T* node) { _parent = utils::pool_ptr<0, T>(node).value; }
+    void set_left(T* node) {
+        Child child = _left;
+        child.set_ptr(node);
+        _left = child.value;
+    }
+    void set_right(T* node) {
+        Child child = _right;
+        child.set_ptr(node);
+        _right = child.value;
+    }
+};
+
+/**
+ * \a CompactBSTNodeBase storing subtree sizes as well
+ */
+template <typename _Key, typename T>
+struct CompactBSTNodeBase<_Key, T, true>: public CompactBSTNodeBase<_Key, T, false> {
+    std::uint32_t size;
+
+    explicit CompactBSTNodeBase(const _Key& key): CompactBSTNodeBase<_Key, T, false>(key), size(0) {}
+};
+
 }
 
 #endif
@@ -0,0 +1,75 @@
+#ifndef _YFAST_INTERNAL_BUCKET_H
+#define _YFAST_INTERNAL_BUCKET_H
+
+#include <cstddef>
+
+#include <yfast/impl/avl.h>
+#include <yfast/impl/sorted_array.h>
+#include <yfast/internal/fastmap.h>
+
+namespace yfast::internal {
+
+/**
+ * \a Buckets template parameter selecting \a yfast::impl::AVL buckets: nodes are linked, so iteration never searches
+ */
+struct AVLBuckets {
+    template <typename Leaf, typename Compare, std::size_t Capacity>
+    using Bucket = impl::AVL<Leaf, Compare>;
+};
+
+/**
+ * \a Buckets template parameter selecting \a yfast::impl::AVL buckets of compact leaves, linked by 32-bit indices into
+ * a process-wide \a yfast::utils::NodePool (POSIX only) instead of pointers: leaves are allocated from the pool
+ * whatever the allocator, and take less than half the memory for small keys and values
+ * @tparam SubtreeSizes whether leaves store their subtree sizes
+ */
+template <bool SubtreeSizes = false>
+struct CompactAVLBuckets: AVLBuckets {
+    template <typename Key, typename Value>
+    using Leaf = YFastLeaf<Key, Value, CompactLayout<SubtreeSizes>>;
+};
+
+/**
+ * \a Buckets template parameter selecting \a yfast::impl::SortedArray buckets (trivially copyable keys only): a lookup
+ * scans a couple of cache lines of contiguous keys instead of descending a tree of about 2H nodes, while iterator
+ * increment takes an in-bucket search
+ */
+struct SortedArrayBuckets {
+    template <typename Leaf, typename Compare, std::size_t Capacity>
+    using Bucket = impl::SortedArray<Leaf, Capacity, Compare>;
+};
+
+/**
+ * \a Buckets template parameter that keeps the buckets of \a Base but represents every bucket in the x-fast trie by
+ * its minimal key (as of the last split or merge) rather than by its median: no bucket but the leftmost one holds a key
+ * less than its representative, so every lookup searches just the bucket of the x-fast trie predecessor (or the
+ * leftmost bucket if there is none)
+ * @tparam Base underlying bucket policy
+ */
+template <typename Base = AVLBuckets>
+struct MinimumRepresentatives: Base {
+    static constexpr bool MIN_REPRESENTATIVES = true;
+};
+
+/**
+ * whether bucket policy \a Buckets represents buckets by their minimal keys
+ */
+template <typename Buckets>
+constexpr bool min_representatives_v = requires { requires Buckets::MIN_REPRESENTATIVES; };
+
+/**
+ * leaf type of bucket policy \a Buckets: its \a Leaf if any, otherwise \a YFastLeaf
+ */
+template <typename Buckets, typename Key, typename Value>
+struct BucketLeaf {
+    typedef YFastLeaf<Key, Value> Type;
+};
+
+template <typename Buckets, typename Key, typename Value> requires requires { typename Buckets::template Leaf<Key, Value>; }
+struct BucketLeaf<Buckets, Key, Value> {
+    typedef typename Buckets::template Leaf<Key, Value> Type;
+};
+
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define _YFAST_INTERNAL_CONCEPTS_H
 
 #include <concepts>
+#include <cstdint>
 
 namespace yfast::internal {
 
@@ -15,12 +16,52 @@ concept MapGeneric = requires (Map map, Key key) {
     { map.clear() };
 };
 
+template <typename Map, typename Key, typename Value>
+concept MapFindGeneric = MapGeneric<Map, Key, Value> && requires (const Map map, Key key) {
+    { map.find(key) == map.end() } -> std::convertible_to<bool>;
+    { map.find(key)->second } -> std::convertible_to<Value>;
+};
+
+template <typename Map, typename Key, typename Value>
+concept MapEraseGeneric = MapFindGeneric<Map, Key, Value> && requires (Map map, Key key) {
+    { map.erase(map.find(key)) };
+};
+
+template <typename Policy, typename ShiftResult>
+concept LevelPolicyGeneric = requires {
+    typename Policy::template Storage<ShiftResult, 1>;
+};
+
+template <typename Policy, typename Leaf, typename Compare>
+concept BucketPolicyGeneric = requires {
+    typename Policy::template Bucket<Leaf, Compare, 1>;
+};
+
+template <typename Policy, unsigned int H>
+concept ThresholdPolicyGeneric = requires (const typename Policy::template Thresholds<H> thresholds) {
+    { Policy::template Thresholds<H>::MAX_SPLIT } -> std::convertible_to<unsigned int>;
+    { Policy::template Thresholds<H>::MAX_MERGE } -> std::convertible_to<unsigned int>;
+    { thresholds.split() } -> std::convertible_to<unsigned int>;
+    { thresholds.merge() } -> std::convertible_to<unsigned int>;
+};
+
+template <typename Allocator>
+concept ArenaAllocatorGeneric = requires (Allocator alloc) {
+    { alloc.release() };
+};
+
+template <typename Hash, typename ShiftResult>
+concept LevelHashGeneric = MapGeneric<Hash, ShiftResult, std::uintptr_t> || LevelPolicyGeneric<Hash, ShiftResult>;
+
 template <typename BitExtractor, typename Key>
 concept BitExtractorGeneric = requires (BitExtractor bx, Key key, unsigned int n) {
     { bx.extract_bit(key, n) } -> std::convertible_to<bool>;
     { bx.shift(key, n) } -> std::convertible_to<typename BitExtractor::ShiftResult>;
 };
 
+template <typename Compare, typename BitExtractor, typename K>
+concept TransparentLookup = requires { typename Compare::is_transparent; } && BitExtractorGeneric<BitExtractor, K>;
+
 }
 
 #endif
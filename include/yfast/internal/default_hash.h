@@ -1,22 +1,87 @@
 #ifndef _YFAST_INTERNAL_DEFAULT_HASH_H
 #define _YFAST_INTERNAL_DEFAULT_HASH_H
 
-#ifdef YFAST_WITHOUT_HOPSCOTCH_MAP
-#include <unordered_map>
-#else
+#include <memory>
+#include <type_traits>
+
+#include <yfast/internal/flat_map.h>
+
+#if !defined(YFAST_WITHOUT_HOPSCOTCH_MAP) && __has_include(<tsl/hopscotch_map.h>)
+#define YFAST_WITH_HOPSCOTCH_MAP
 #include <tsl/hopscotch_map.h>
+#else
+#include <unordered_map>
 #endif
 
 namespace yfast::internal {
 
-#ifdef YFAST_WITHOUT_HOPSCOTCH_MAP
-template <typename Key, typename Value>
-using DefaultHash = std::unordered_map<Key, Value>;
+template <typename Key, typename Value, typename = void>
+struct DefaultHashSelector {
+#ifdef YFAST_WITH_HOPSCOTCH_MAP
+    typedef tsl::hopscotch_map<Key, Value> Type;
 #else
+    typedef std::unordered_map<Key, Value> Type;
+#endif
+};
+
 template <typename Key, typename Value>
-using DefaultHash = tsl::hopscotch_map<Key, Value>;
+struct DefaultHashSelector<Key, Value, std::void_t<decltype(PrefixHash<Key>()(std::declval<const Key&>()))>> {
+    typedef FlatMap<Key, Value> Type;
+};
+
+/**
+ * \a yfast::internal::FlatMap for shifted keys supported by \a yfast::internal::PrefixHash; otherwise
+ * \a tsl::hopscotch_map if available (unless \a YFAST_WITHOUT_HOPSCOTCH_MAP is defined) or \a std::unordered_map
+ */
+template <typename Key, typename Value>
+using DefaultHash = typename DefaultHashSelector<Key, Value>::Type;
+
+/**
+ * \a Hash with its allocator replaced by \a Allocator (rebound to its entries) if it is one of the default maps with
+ * the default \a std::allocator; \a Hash itself otherwise, i.e. explicitly specified allocators are kept
+ */
+template <typename Hash, typename Allocator>
+struct RebindHash {
+    typedef Hash Type;
+};
+
+template <typename Key, typename Value, typename Hasher, typename Entry, typename Allocator>
+struct RebindHash<FlatMap<Key, Value, Hasher, std::allocator<Entry>>, Allocator> {
+    typedef FlatMap<Key, Value, Hasher, typename std::allocator_traits<Allocator>::template rebind_alloc<Entry>> Type;
+};
+
+#ifdef YFAST_WITH_HOPSCOTCH_MAP
+template <typename Key, typename Value, typename Hasher, typename Equal, typename Entry, unsigned int N, bool S, typename G, typename Allocator>
+struct RebindHash<tsl::hopscotch_map<Key, Value, Hasher, Equal, std::allocator<Entry>, N, S, G>, Allocator> {
+    typedef tsl::hopscotch_map<Key, Value, Hasher, Equal, typename std::allocator_traits<Allocator>::template rebind_alloc<Entry>, N, S, G> Type;
+};
+#else
+template <typename Key, typename Value, typename Hasher, typename Equal, typename Entry, typename Allocator>
+struct RebindHash<std::unordered_map<Key, Value, Hasher, Equal, std::allocator<Entry>>, Allocator> {
+    typedef std::unordered_map<Key, Value, Hasher, Equal, typename std::allocator_traits<Allocator>::template rebind_alloc<Entry>> Type;
+};
 #endif
 
+/**
+ * @return empty \a Hash using \a alloc (rebound to its entries) if its allocator converts from \a Allocator;
+ * default-constructed \a Hash otherwise
+ */
+template <typename Hash, typename Allocator>
+Hash make_hash(const Allocator& alloc) {
+    if constexpr (requires { typename Hash::allocator_type; }) {
+        typedef typename Hash::allocator_type HashAllocator;
+        if constexpr (std::is_constructible_v<HashAllocator, const Allocator&> && std::is_constructible_v<Hash, const HashAllocator&>) {
+            return Hash(HashAllocator(alloc));
+        }
+        else {
+            return Hash();
+        }
+    }
+    else {
+        return Hash();
+    }
+}
+
 }
 
 #endif
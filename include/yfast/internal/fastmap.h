@@ -1,39 +1,55 @@
 #ifndef _YFAST_INTERNAL_FASTMAP_H
 #define _YFAST_INTERNAL_FASTMAP_H
 
+#include <memory>
 #include <utility>
 
 #include <yfast/internal/avl.h>
 
 namespace yfast::internal {
 
-template <typename Key, typename Value>
+template <typename Key, typename Value, typename Layout = PointerLayout>
 struct YFastLeaf;
 
-template <typename Key, typename Value>
-struct YFastLeaf: public AVLNodeBase<Key, YFastLeaf<Key, Value>> {
+template <typename Key, typename Value, typename Layout>
+struct YFastLeaf: public Layout::template NodeBase<Key, YFastLeaf<Key, Value, Layout>> {
+    typedef typename Layout::template NodeBase<Key, YFastLeaf> NodeBase;
     typedef Value DerefType;
 
     Value value;
 
-    explicit YFastLeaf(const Key& key): AVLNodeBase<Key, YFastLeaf>(key), value() {}
-    explicit YFastLeaf(const Key& key, const Value& value): AVLNodeBase<Key, YFastLeaf>(key), value(value) {}
-    explicit YFastLeaf(const Key& key, Value&& value): AVLNodeBase<Key, YFastLeaf>(key), value(std::move(value)) {}
+    explicit YFastLeaf(const Key& key): NodeBase(key), value() {}
+    explicit YFastLeaf(const Key& key, const Value& value): NodeBase(key), value(value) {}
+    explicit YFastLeaf(const Key& key, Value&& value): NodeBase(key), value(std::move(value)) {}
 
     DerefType& deref() { return value; }
 };
 
-template <typename Key>
-struct YFastLeaf<Key, void>: public AVLNodeBase<Key, YFastLeaf<Key, void>> {
+template <typename Key, typename Layout>
+struct YFastLeaf<Key, void, Layout>: public Layout::template NodeBase<Key, YFastLeaf<Key, void, Layout>> {
+    typedef typename Layout::template NodeBase<Key, YFastLeaf> NodeBase;
     typedef const Key DerefType;
 
-    using AVLNodeBase<Key, YFastLeaf>::key;
+    using NodeBase::key;
 
-    explicit YFastLeaf(const Key& key): AVLNodeBase<Key, YFastLeaf>(key) {}
+    explicit YFastLeaf(const Key& key): NodeBase(key) {}
 
     DerefType& deref() { return key; }
 };
 
+/**
+ * allocator of \a Leaf: the one its layout requires (if any), otherwise \a Allocator rebound
+ */
+template <typename Leaf, typename Allocator>
+struct LeafAllocator {
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<Leaf> Type;
+};
+
+template <typename Leaf, typename Allocator> requires requires { typename Leaf::Allocator; }
+struct LeafAllocator<Leaf, Allocator> {
+    typedef typename Leaf::Allocator Type;
+};
+
 }
 
 #endif
@@ -0,0 +1,145 @@
+#ifndef _YFAST_INTERNAL_FIXED_WORDS_H
+#define _YFAST_INTERNAL_FIXED_WORDS_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <yfast/internal/flat_map.h>
+#include <yfast/internal/integral.h>
+
+namespace yfast::internal {
+
+/**
+ * @return 8 bytes at \a data read as a big-endian number
+ */
+inline std::uint64_t load_big_endian(const std::byte* data) {
+    std::uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    if constexpr (std::endian::native == std::endian::little) {
+#if defined(__GNUC__) || defined(__clang__)
+        word = __builtin_bswap64(word);
+#else
+        std::uint64_t swapped = 0;
+        for (unsigned int i = 0; i < sizeof(word); ++i) {
+            swapped = (swapped << 8) | ((word >> (8 * i)) & 0xff);
+        }
+        word = swapped;
+#endif
+    }
+    return word;
+}
+
+/**
+ * unsigned number of \a W 64-bit words (the most significant one first) for keys wider than the widest integral type
+ * @tparam W number of words
+ */
+template <std::size_t W>
+struct FixedWords {
+    std::uint64_t words[W];
+
+    bool operator == (const FixedWords& other) const = default;
+
+    /**
+     * @param n shift in bits; less than \a 64 * W
+     */
+    FixedWords operator >> (unsigned int n) const {
+        const auto s = n / 64;
+        const auto r = n % 64;
+        FixedWords shifted;
+        for (std::size_t j = W; j-- > 0; ) {
+            if (j < s) {
+                shifted.words[j] = 0;
+            }
+            else if (r == 0) {
+                shifted.words[j] = words[j - s];
+            }
+            else {
+                shifted.words[j] = (words[j - s] >> r) | (j > s ? words[j - s - 1] << (64 - r) : 0);
+            }
+        }
+        return shifted;
+    }
+
+    [[nodiscard]] bool bit(unsigned int n) const {
+        return (words[W - 1 - n / 64] >> (n % 64)) & 1;
+    }
+};
+
+// shifted keys are mostly zero in the upper words, so the lowest word is mixed last
+template <std::size_t W>
+struct PrefixHash<FixedWords<W>> {
+    std::uint64_t operator () (const FixedWords<W>& key) const noexcept {
+        std::uint64_t hash = 0;
+        for (std::size_t j = 0; j < W; ++j) {
+            hash = prefix_mix(hash ^ key.words[j]);
+        }
+        return hash;
+    }
+};
+
+/**
+ * the narrowest unsigned number type holding \a N bytes: \a std::uint64_t, \a UInt128 (if available) or
+ * \a FixedWords
+ */
+template <std::size_t N, typename = void>
+struct FixedWidthNumber {
+    typedef FixedWords<(N + 7) / 8> Type;
+};
+
+template <std::size_t N>
+struct FixedWidthNumber<N, std::enable_if_t<(N <= sizeof(std::uint64_t))>> {
+    typedef std::uint64_t Type;
+};
+
+#ifdef __SIZEOF_INT128__
+template <std::size_t N>
+struct FixedWidthNumber<N, std::enable_if_t<(N > sizeof(std::uint64_t) && N <= sizeof(UInt128))>> {
+    typedef UInt128 Type;
+};
+#endif
+
+/**
+ * @return \a N bytes at \a data read as a big-endian number
+ */
+template <std::size_t N>
+typename FixedWidthNumber<N>::Type load_big_endian(const std::byte* data) {
+    typedef typename FixedWidthNumber<N>::Type Number;
+    constexpr auto head = N % 8;  // leading bytes that do not make up a whole word
+    if constexpr (is_integral_v<Number>) {
+        Number number = 0;
+        for (std::size_t i = 0; i < head; ++i) {
+            number = (number << 8) | static_cast<std::uint8_t>(data[i]);
+        }
+        for (std::size_t i = head; i < N; i += 8) {
+            if constexpr (sizeof(Number) > sizeof(std::uint64_t)) {
+                number = (number << 64) | load_big_endian(data + i);
+            }
+            else {
+                number = load_big_endian(data + i);
+            }
+        }
+        return number;
+    }
+    else {
+        Number number;
+        std::size_t j = 0;
+        if constexpr (head > 0) {
+            number.words[j] = 0;
+            for (std::size_t i = 0; i < head; ++i) {
+                number.words[j] = (number.words[j] << 8) | static_cast<std::uint8_t>(data[i]);
+            }
+            ++j;
+        }
+        for (std::size_t i = head; i < N; i += 8) {
+            number.words[j++] = load_big_endian(data + i);
+        }
+        return number;
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,511 @@
+#ifndef _YFAST_INTERNAL_FLAT_MAP_H
+#define _YFAST_INTERNAL_FLAT_MAP_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <yfast/internal/integral.h>
+#include <yfast/utils/prefetch.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace yfast::internal {
+
+/**
+ * hash function for shifted integral keys \n
+ * shifted keys of a single level are mostly dense ranges of small integers, so every bit of the key gets spread over
+ * the whole word by a folded multiplication
+ * @tparam Key shifted key type
+ */
+template <typename Key, typename = void>
+struct PrefixHash;
+
+inline std::uint64_t prefix_mix(std::uint64_t x) {
+#ifdef __SIZEOF_INT128__
+    const auto m = static_cast<unsigned __int128>(x) * 0x9e3779b97f4a7c15ULL;
+    return static_cast<std::uint64_t>(m) ^ static_cast<std::uint64_t>(m >> 64);
+#else
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    x ^= x >> 32;
+    x *= 0xd6e8feb86659fd93ULL;
+    return x ^ (x >> 32);
+#endif
+}
+
+template <typename Key>
+struct PrefixHash<Key, std::enable_if_t<is_integral_v<Key> && sizeof(Key) <= sizeof(std::uint64_t)>> {
+    std::uint64_t operator () (Key key) const noexcept {
+        return prefix_mix(static_cast<std::uint64_t>(key));
+    }
+};
+
+#ifdef __SIZEOF_INT128__
+// upper levels of 128-bit keys only keep the high word, so it must reach every bit of the hash
+template <typename Key>
+struct PrefixHash<Key, std::enable_if_t<is_integral_v<Key> && sizeof(Key) == sizeof(UInt128)>> {
+    std::uint64_t operator () (Key key) const noexcept {
+        const auto k = static_cast<UInt128>(key);
+        return prefix_mix(static_cast<std::uint64_t>(k) ^ prefix_mix(static_cast<std::uint64_t>(k >> 64)));
+    }
+};
+#endif
+
+/**
+ * control byte group: \a Width consecutive control bytes matched at once
+ */
+struct FlatMapGroup {
+    typedef std::int8_t ctrl_t;
+
+    static constexpr ctrl_t EMPTY = -128;  // 0b10000000
+    static constexpr ctrl_t DELETED = -2;  // 0b11111110
+    static constexpr ctrl_t SENTINEL = -1;  // 0b11111111
+
+    /**
+     * set of matching positions within a group
+     */
+    struct BitMask {
+        std::uint64_t mask;
+
+        explicit operator bool () const { return mask != 0; }
+#if defined(__SSE2__) || defined(_M_X64)
+        [[nodiscard]] unsigned int lowest() const { return std::countr_zero(mask); }
+#else
+        [[nodiscard]] unsigned int lowest() const { return std::countr_zero(mask) >> 3; }
+#endif
+        void clear_lowest() { mask &= mask - 1; }
+    };
+
+#if defined(__SSE2__) || defined(_M_X64)
+    static constexpr std::size_t Width = 16;
+
+    __m128i ctrl;
+
+    explicit FlatMapGroup(const ctrl_t* pos): ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos))) {}
+
+    [[nodiscard]] BitMask match(ctrl_t h2) const {
+        return { static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), ctrl))) };
+    }
+
+    [[nodiscard]] BitMask match_empty() const {
+        return match(EMPTY);
+    }
+
+    [[nodiscard]] BitMask match_empty_or_deleted() const {
+        return { static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(SENTINEL), ctrl))) };
+    }
+#else
+    static constexpr std::size_t Width = 8;
+
+    static constexpr std::uint64_t LSBS = 0x0101010101010101ULL;
+    static constexpr std::uint64_t MSBS = 0x8080808080808080ULL;
+
+    std::uint64_t ctrl;
+
+    explicit FlatMapGroup(const ctrl_t* pos) { std::memcpy(&ctrl, pos, sizeof(ctrl)); }
+
+#if defined(__ARM_NEON)
+    [[nodiscard]] BitMask match(ctrl_t h2) const {
+        const auto eq = vceq_u8(vcreate_u8(ctrl), vdup_n_u8(static_cast<std::uint8_t>(h2)));
+        return { vget_lane_u64(vreinterpret_u64_u8(eq), 0) & MSBS };
+    }
+#else
+    // may yield false positives, which are sorted out by key comparison anyway
+    [[nodiscard]] BitMask match(ctrl_t h2) const {
+        const auto x = ctrl ^ (LSBS * static_cast<std::uint8_t>(h2));
+        return { (x - LSBS) & ~x & MSBS };
+    }
+#endif
+
+    [[nodiscard]] BitMask match_empty() const {
+        return { ctrl & ~(ctrl << 6) & MSBS };
+    }
+
+    [[nodiscard]] BitMask match_empty_or_deleted() const {
+        return { ctrl & ~(ctrl << 7) & MSBS };
+    }
+#endif
+};
+
+template <typename Key, typename Value>
+struct FlatMapSlot {
+    Key first;
+    Value second;
+};
+
+/**
+ * open addressing hash map with a flat control byte array probed a group at a time (Swiss table layout) \n
+ * meant as a level table of \a yfast::impl::XFastTrie: both keys and values must be trivially copyable
+ * @tparam Key key type
+ * @tparam Value value type
+ * @tparam Hash hash function
+ * @tparam Allocator allocator; rebound to allocate control bytes and slots in a single block
+ */
+template <
+    typename Key,
+    typename Value,
+    typename Hash = PrefixHash<Key>,
+    typename Allocator = std::allocator<std::pair<const Key, Value>>
+>
+class FlatMap {
+    static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>, "Trivially copyable types required");
+
+public:
+    typedef Key key_type;
+    typedef Value mapped_type;
+    typedef FlatMapSlot<Key, Value> value_type;
+    typedef std::size_t size_type;
+    typedef Allocator allocator_type;
+
+private:
+    typedef FlatMapGroup Group;
+    typedef Group::ctrl_t ctrl_t;
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<value_type> Alloc;
+
+    template <bool Const>
+    class IteratorBase {
+        friend class FlatMap;
+        template <bool> friend class IteratorBase;
+
+        typedef std::conditional_t<Const, const value_type, value_type> Slot;
+
+        const ctrl_t* _ctrl;
+        Slot* _slot;
+
+        IteratorBase(const ctrl_t* ctrl, Slot* slot): _ctrl(ctrl), _slot(slot) {}
+
+        void skip_free() {
+            while (*_ctrl < Group::SENTINEL) {
+                ++_ctrl;
+                ++_slot;
+            }
+        }
+
+    public:
+        IteratorBase() = default;
+        template <bool Const_> requires (Const && !Const_)
+        IteratorBase(const IteratorBase<Const_>& other): _ctrl(other._ctrl), _slot(other._slot) {}
+
+        Slot& operator * () const { return *_slot; }
+        Slot* operator -> () const { return _slot; }
+
+        IteratorBase& operator ++ () {
+            ++_ctrl;
+            ++_slot;
+            skip_free();
+            return *this;
+        }
+
+        template <bool Const_>
+        bool operator == (const IteratorBase<Const_>& other) const { return _slot == other._slot; }
+    };
+
+public:
+    typedef IteratorBase<false> iterator;
+    typedef IteratorBase<true> const_iterator;
+
+private:
+    static constexpr std::size_t GROUP_WIDTH = Group::Width;
+
+    Alloc _alloc;
+    Hash _hasher;
+    ctrl_t* _ctrl;
+    value_type* _slots;
+    std::size_t _capacity;
+    std::size_t _size;
+    std::size_t _growth_left;
+
+public:
+    FlatMap(): FlatMap(Allocator()) {}
+    explicit FlatMap(const Allocator& alloc): _alloc(alloc), _hasher(), _ctrl(empty_group()), _slots(nullptr), _capacity(0), _size(0), _growth_left(0) {}
+    FlatMap(const FlatMap& other) = delete;
+    FlatMap(FlatMap&& other) noexcept: _alloc(other._alloc), _hasher(other._hasher), _ctrl(other._ctrl), _slots(other._slots), _capacity(other._capacity), _size(other._size), _growth_left(other._growth_left) {
+        other.reset();
+    }
+
+    FlatMap& operator = (FlatMap&& other) noexcept {
+        if (this != &other) {
+            deallocate();
+            _alloc = other._alloc;
+            _hasher = other._hasher;
+            _ctrl = other._ctrl;
+            _slots = other._slots;
+            _capacity = other._capacity;
+            _size = other._size;
+            _growth_left = other._growth_left;
+            other.reset();
+        }
+        return *this;
+    }
+
+    ~FlatMap() { deallocate(); }
+
+    [[nodiscard]] std::size_t size() const { return _size; }
+    [[nodiscard]] bool empty() const { return _size == 0; }
+    [[nodiscard]] std::size_t capacity() const { return _capacity; }
+    allocator_type get_allocator() const { return allocator_type(_alloc); }
+
+    iterator begin() {
+        iterator i(_ctrl, _slots);
+        i.skip_free();
+        return i;
+    }
+
+    iterator end() { return iterator(_ctrl + _capacity, _slots + _capacity); }
+
+    const_iterator begin() const {
+        const_iterator i(_ctrl, _slots);
+        i.skip_free();
+        return i;
+    }
+
+    const_iterator end() const { return const_iterator(_ctrl + _capacity, _slots + _capacity); }
+
+    iterator find(const Key& key) {
+        auto index = seek(key);
+        return iterator(_ctrl + index, _slots + index);
+    }
+
+    const_iterator find(const Key& key) const {
+        auto index = seek(key);
+        return const_iterator(_ctrl + index, _slots + index);
+    }
+
+    /**
+     * start loading the control group and the slot a lookup of \a key probes first
+     */
+    void prefetch(const Key& key) const {
+        const auto pos = h1(_hasher(key)) & _capacity;
+        utils::prefetch(_ctrl + pos);
+        if (_slots != nullptr) {
+            utils::prefetch(_slots + pos);
+        }
+    }
+
+    [[nodiscard]] bool contains(const Key& key) const { return seek(key) != _capacity; }
+
+    const Value& at(const Key& key) const {
+        auto index = seek(key);
+        if (index == _capacity) {
+            throw std::out_of_range("yfast::internal::FlatMap::at");
+        }
+        return _slots[index].second;
+    }
+
+    Value& at(const Key& key) {
+        auto index = seek(key);
+        if (index == _capacity) {
+            throw std::out_of_range("yfast::internal::FlatMap::at");
+        }
+        return _slots[index].second;
+    }
+
+    Value& operator [] (const Key& key) {
+        return try_emplace(key).first->second;
+    }
+
+    /**
+     * insert a value unless the key is already present
+     * @return iterator to the entry with the key and whether it has been inserted
+     */
+    std::pair<iterator, bool> try_emplace(const Key& key, Value value = Value()) {
+        const auto hash = _hasher(key);
+        auto index = seek(key, hash);
+        if (index != _capacity) {
+            return { iterator(_ctrl + index, _slots + index), false };
+        }
+        index = find_free(hash);
+        if (_growth_left == 0 && _ctrl[index] != Group::DELETED) {
+            rehash(std::max<std::size_t>(2 * _size, 1));
+            index = find_free(hash);
+        }
+        if (_ctrl[index] == Group::EMPTY) {
+            --_growth_left;
+        }
+        set_ctrl(index, h2(hash));
+        _slots[index] = { key, value };
+        ++_size;
+        return { iterator(_ctrl + index, _slots + index), true };
+    }
+
+    std::size_t erase(const Key& key) {
+        auto index = seek(key);
+        if (index == _capacity) {
+            return 0;
+        }
+        erase_at(index);
+        return 1;
+    }
+
+    void erase(const_iterator i) {
+        erase_at(i._slot - _slots);
+    }
+
+    void erase(iterator i) {
+        erase_at(i._slot - _slots);
+    }
+
+    /**
+     * erase all the entries; capacity is retained
+     */
+    void clear() {
+        if (_capacity > 0) {
+            std::memset(_ctrl, Group::EMPTY, _capacity + GROUP_WIDTH);
+            _ctrl[_capacity] = Group::SENTINEL;
+            _size = 0;
+            _growth_left = max_load(_capacity);
+        }
+    }
+
+    /**
+     * allocate room for at least \a n entries
+     * @param n number of entries
+     */
+    void reserve(std::size_t n) {
+        if (n > _size + _growth_left) {
+            rehash(n);
+        }
+    }
+
+private:
+    // an empty table still probes a single group: nothing matches, and inserts see no room
+    static ctrl_t* empty_group() {
+        alignas(16) static ctrl_t ctrl[GROUP_WIDTH] = {
+            Group::SENTINEL, Group::EMPTY, Group::EMPTY, Group::EMPTY,
+            Group::EMPTY, Group::EMPTY, Group::EMPTY, Group::EMPTY,
+#if defined(__SSE2__) || defined(_M_X64)
+            Group::EMPTY, Group::EMPTY, Group::EMPTY, Group::EMPTY,
+            Group::EMPTY, Group::EMPTY, Group::EMPTY, Group::EMPTY,
+#endif
+        };
+        return ctrl;
+    }
+
+    // at least one slot is always left empty to terminate probing
+    static std::size_t max_load(std::size_t capacity) { return capacity == 7 ? 6 : capacity - capacity / 8; }
+
+    static std::size_t h1(std::uint64_t hash) { return hash >> 7; }
+    static ctrl_t h2(std::uint64_t hash) { return static_cast<ctrl_t>(hash & 0x7f); }
+
+    std::size_t seek(const Key& key) const { return seek(key, _hasher(key)); }
+
+    /**
+     * @return slot index or \a _capacity if absent
+     */
+    std::size_t seek(const Key& key, std::uint64_t hash) const {
+        const auto mask = _capacity;
+        auto pos = h1(hash) & mask;
+        for (std::size_t step = GROUP_WIDTH; ; step += GROUP_WIDTH) {
+            Group group(_ctrl + pos);
+            for (auto match = group.match(h2(hash)); match; match.clear_lowest()) {
+                auto index = (pos + match.lowest()) & mask;
+                if (_slots[index].first == key) {
+                    return index;
+                }
+            }
+            if (group.match_empty()) {
+                return _capacity;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    std::size_t find_free(std::uint64_t hash) const {
+        const auto mask = _capacity;
+        auto pos = h1(hash) & mask;
+        for (std::size_t step = GROUP_WIDTH; ; step += GROUP_WIDTH) {
+            auto match = Group(_ctrl + pos).match_empty_or_deleted();
+            if (match) {
+                return (pos + match.lowest()) & mask;
+            }
+            pos = (pos + step) & mask;
+        }
+    }
+
+    void set_ctrl(std::size_t index, ctrl_t c) {
+        _ctrl[index] = c;
+        if (index < GROUP_WIDTH - 1) {
+            _ctrl[_capacity + 1 + index] = c;  // cloned bytes let a group be loaded at any position
+        }
+    }
+
+    void erase_at(std::size_t index) {
+        set_ctrl(index, Group::DELETED);
+        --_size;
+    }
+
+    /**
+     * reallocate for at least \a n entries; tombstones are dropped, so the capacity may stay the same
+     */
+    void rehash(std::size_t n) {
+        std::size_t capacity = GROUP_WIDTH - 1;
+        while (max_load(capacity) < n) {
+            capacity = 2 * capacity + 1;
+        }
+        auto old_ctrl = _ctrl;
+        auto old_slots = _slots;
+        auto old_capacity = _capacity;
+        auto old_block = reinterpret_cast<value_type*>(_ctrl);
+
+        allocate(capacity);
+        for (std::size_t index = 0; index < old_capacity; ++index) {
+            if (old_ctrl[index] >= 0) {
+                const auto hash = _hasher(old_slots[index].first);
+                auto new_index = find_free(hash);
+                set_ctrl(new_index, h2(hash));
+                _slots[new_index] = old_slots[index];
+            }
+        }
+        _growth_left -= _size;
+
+        if (old_capacity > 0) {
+            std::allocator_traits<Alloc>::deallocate(_alloc, old_block, slot_count(old_capacity));
+        }
+    }
+
+    static std::size_t slot_count(std::size_t capacity) {
+        const auto ctrl_size = capacity + GROUP_WIDTH;
+        return (ctrl_size + sizeof(value_type) - 1) / sizeof(value_type) + capacity;
+    }
+
+    // capacity is always 2^k - 1 so that it doubles as the probe mask
+    // [ctrl: capacity | SENTINEL | GROUP_WIDTH - 1 cloned | padding] [slots: capacity]
+    void allocate(std::size_t capacity) {
+        auto block = std::allocator_traits<Alloc>::allocate(_alloc, slot_count(capacity));
+        _ctrl = reinterpret_cast<ctrl_t*>(block);
+        _slots = block + (slot_count(capacity) - capacity);
+        _capacity = capacity;
+        std::memset(_ctrl, Group::EMPTY, capacity + GROUP_WIDTH);
+        _ctrl[capacity] = Group::SENTINEL;
+        _growth_left = max_load(capacity);
+    }
+
+    void deallocate() {
+        if (_capacity > 0) {
+            std::allocator_traits<Alloc>::deallocate(_alloc, reinterpret_cast<value_type*>(_ctrl), slot_count(_capacity));
+        }
+    }
+
+    void reset() {
+        _ctrl = empty_group();
+        _slots = nullptr;
+        _capacity = 0;
+        _size = 0;
+        _growth_left = 0;
+    }
+};
+
+}
+
+#endif
@@ -5,6 +5,10 @@
 #include <string_view>
 #include <vector>
 
+#include <yfast/internal/fixed_words.h>
+#include <yfast/internal/hashed_prefix.h>
+#include <yfast/internal/inline_bytes.h>
+
 namespace std {
 
 template <>
@@ -14,6 +18,27 @@ struct hash<vector<byte>> {
     }
 };
 
+template <size_t W>
+struct hash<yfast::internal::FixedWords<W>> {
+    size_t operator()(const yfast::internal::FixedWords<W>& number) const noexcept {
+        return yfast::internal::PrefixHash<yfast::internal::FixedWords<W>>{}(number);
+    }
+};
+
+template <>
+struct hash<yfast::internal::HashedPrefix> {
+    size_t operator()(const yfast::internal::HashedPrefix& prefix) const noexcept {
+        return prefix.hash();
+    }
+};
+
+template <size_t N>
+struct hash<yfast::internal::InlineBytes<N>> {
+    size_t operator()(const yfast::internal::InlineBytes<N>& array) const noexcept {
+        return hash<string_view>{}({reinterpret_cast<const char*>(array.data()), array.size()});
+    }
+};
+
 }
 
 #endif
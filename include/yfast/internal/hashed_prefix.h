@@ -0,0 +1,130 @@
+#ifndef _YFAST_INTERNAL_HASHED_PREFIX_H
+#define _YFAST_INTERNAL_HASHED_PREFIX_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <yfast/internal/flat_map.h>
+
+namespace yfast::internal {
+
+/**
+ * leading bits of a byte string along with their precomputed hash; equal to another prefix iff both have the same
+ * number of bits and the same bits, i.e. iff their right-aligned byte strings (as produced by
+ * \a BitExtractor<std::vector<std::byte>>::shift()) are equal; bytes are only compared if hashes match \n
+ * a prefix made by \a HashedPrefixes is a view into the key it was made of; copies own their bytes (so that level
+ * tables never refer to keys) while moves keep the source's state
+ */
+class HashedPrefix {
+    std::uint64_t _hash;
+    std::size_t _bits;
+    const std::byte* _data;
+    std::unique_ptr<std::byte[]> _buffer;
+
+public:
+    HashedPrefix(): _hash(0), _bits(0), _data(nullptr) {}
+
+    /**
+     * @param data byte string the prefix is a view into
+     * @param bits prefix length in bits
+     * @param hash prefix hash
+     */
+    HashedPrefix(const std::byte* data, std::size_t bits, std::uint64_t hash): _hash(hash), _bits(bits), _data(data) {}
+
+    HashedPrefix(const HashedPrefix& other): _hash(other._hash), _bits(other._bits), _data(nullptr) {
+        copy(other);
+    }
+
+    HashedPrefix(HashedPrefix&& other) noexcept = default;
+
+    HashedPrefix& operator = (const HashedPrefix& other) {
+        if (this != &other) {
+            _hash = other._hash;
+            _bits = other._bits;
+            copy(other);
+        }
+        return *this;
+    }
+
+    HashedPrefix& operator = (HashedPrefix&& other) noexcept = default;
+
+    [[nodiscard]] std::uint64_t hash() const { return _hash; }
+    [[nodiscard]] std::size_t bits() const { return _bits; }
+
+    bool operator == (const HashedPrefix& other) const {
+        if (_hash != other._hash || _bits != other._bits) {
+            return false;
+        }
+        const auto s = _bits / 8;
+        if (s > 0 && std::memcmp(_data, other._data, s) != 0) {
+            return false;
+        }
+        const auto r = _bits % 8;
+        return r == 0 || ((_data[s] ^ other._data[s]) >> (8 - r)) == std::byte{0};
+    }
+
+private:
+    void copy(const HashedPrefix& other) {
+        const auto size = (_bits + 7) / 8;
+        _buffer.reset(size > 0 ? new std::byte[size] : nullptr);
+        std::copy(other._data, other._data + size, _buffer.get());
+        _data = _buffer.get();
+    }
+};
+
+/**
+ * hashes of all the prefixes of a single byte string of at most \a N bytes computed in a single pass, so that any
+ * of them is then made in constant time
+ * @tparam N maximal byte string length
+ */
+template <std::size_t N>
+class HashedPrefixes {
+    static constexpr std::size_t WORDS = N / 8 + 1;
+
+    const std::byte* _data = nullptr;
+    std::size_t _size = 0;
+    std::uint64_t _words[WORDS];  // big-endian 64-bit words of the string, zero-padded
+    std::uint64_t _ladder[WORDS];  // _ladder[k] -- hash of the first k words
+
+public:
+    HashedPrefixes() = default;
+
+    /**
+     * @param data byte string; must outlive the prefixes made
+     * @param size byte string length; \a std::length_error is thrown if greater than \a N
+     */
+    HashedPrefixes(const std::byte* data, std::size_t size): _data(data), _size(size) {
+        if (size > N) {
+            throw std::length_error("Byte string exceeds hashed prefix capacity");
+        }
+        const auto words = size / 8 + 1;  // prefixes never reach past the word holding the last byte
+        std::fill(_words, _words + words, 0);
+        for (std::size_t i = 0; i < size; ++i) {
+            _words[i / 8] |= static_cast<std::uint64_t>(data[i]) << (56 - 8 * (i % 8));
+        }
+        _ladder[0] = 0;
+        for (std::size_t k = 1; k < words; ++k) {
+            _ladder[k] = prefix_mix(_ladder[k - 1] ^ prefix_mix(_words[k - 1]));
+        }
+    }
+
+    /**
+     * @param n shift in bits
+     * @return prefix equal to the byte string shifted by \a n bits
+     */
+    HashedPrefix operator () (unsigned int n) const {
+        const auto bits = 8 * _size > n ? 8 * _size - n : 0;
+        const auto k = bits / 64;
+        const auto r = bits % 64;
+        const auto partial = r > 0 ? _words[k] >> (64 - r) : 0;
+        return { _data, bits, prefix_mix(_ladder[k] ^ prefix_mix(partial ^ bits)) };
+    }
+};
+
+}
+
+#endif
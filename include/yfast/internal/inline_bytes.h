@@ -0,0 +1,51 @@
+#ifndef _YFAST_INTERNAL_INLINE_BYTES_H
+#define _YFAST_INTERNAL_INLINE_BYTES_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+namespace yfast::internal {
+
+/**
+ * byte string of at most \a N bytes stored inline, i.e. a shifted byte key that takes no heap allocation
+ * @tparam N capacity in bytes
+ */
+template <std::size_t N>
+class InlineBytes {
+    static_assert(N > 0 && N <= UINT16_MAX, "Unsupported capacity");
+
+    std::uint16_t _size;
+    std::array<std::byte, N> _data;
+
+public:
+    InlineBytes(): _size(0) {}
+
+    /**
+     * @param size string length; \a std::length_error is thrown if greater than \a N
+     */
+    explicit InlineBytes(std::size_t size): _size(static_cast<std::uint16_t>(size)) {
+        if (size > N) {
+            throw std::length_error("Byte string exceeds inline capacity");
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const { return _size; }
+    [[nodiscard]] bool empty() const { return _size == 0; }
+
+    std::byte* data() { return _data.data(); }
+    [[nodiscard]] const std::byte* data() const { return _data.data(); }
+
+    std::byte& operator [] (std::size_t i) { return _data[i]; }
+    const std::byte& operator [] (std::size_t i) const { return _data[i]; }
+
+    bool operator == (const InlineBytes& other) const {
+        return _size == other._size && std::memcmp(_data.data(), other._data.data(), _size) == 0;
+    }
+};
+
+}
+
+#endif
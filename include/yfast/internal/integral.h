@@ -0,0 +1,63 @@
+#ifndef _YFAST_INTERNAL_INTEGRAL_H
+#define _YFAST_INTERNAL_INTEGRAL_H
+
+#include <type_traits>
+
+namespace yfast::internal {
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef __int128 Int128;
+__extension__ typedef unsigned __int128 UInt128;
+#endif
+
+/**
+ * \a std::is_integral that also holds for 128-bit integers in strict ISO mode
+ */
+template <typename T>
+struct IsIntegral: std::is_integral<T> {};
+
+/**
+ * \a std::make_unsigned that also works for 128-bit integers in strict ISO mode
+ */
+template <typename T>
+struct MakeUnsigned: std::make_unsigned<T> {};
+
+#ifdef __SIZEOF_INT128__
+template <>
+struct IsIntegral<Int128>: std::true_type {};
+
+template <>
+struct IsIntegral<UInt128>: std::true_type {};
+
+template <>
+struct MakeUnsigned<Int128> {
+    typedef UInt128 type;
+};
+
+template <>
+struct MakeUnsigned<UInt128> {
+    typedef UInt128 type;
+};
+#endif
+
+template <typename T>
+constexpr bool is_integral_v = IsIntegral<T>::value;
+
+template <typename T>
+using make_unsigned_t = typename MakeUnsigned<T>::type;
+
+/**
+ * \a std::is_signed restricted to integral types that also holds for 128-bit integers in strict ISO mode
+ */
+template <typename T, bool = IsIntegral<T>::value>
+struct IsSigned: std::false_type {};
+
+template <typename T>
+struct IsSigned<T, true>: std::bool_constant<(T(-1) < T(0))> {};
+
+template <typename T>
+constexpr bool is_signed_v = IsSigned<T>::value;
+
+}
+
+#endif
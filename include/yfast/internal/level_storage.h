@@ -0,0 +1,542 @@
+#ifndef _YFAST_INTERNAL_LEVEL_STORAGE_H
+#define _YFAST_INTERNAL_LEVEL_STORAGE_H
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include <yfast/internal/concepts.h>
+#include <yfast/internal/default_hash.h>
+#include <yfast/internal/flat_map.h>
+#include <yfast/internal/integral.h>
+#include <yfast/utils/prefetch.h>
+
+namespace yfast::internal {
+
+/**
+ * upper bound of the number of x-fast trie nodes at level \a h for \a n leaves
+ */
+template <unsigned int H>
+std::size_t level_capacity(unsigned int h, std::size_t n) {
+    const auto bits = H - h;
+    return bits < 8 * sizeof(std::size_t) ? std::min(n, std::size_t{1} << bits) : n;
+}
+
+/**
+ * mutable reference to the value an iterator points at
+ */
+template <typename Iterator>
+std::uintptr_t& iterator_value(const Iterator& i) {
+    if constexpr (requires { { i.value() } -> std::same_as<std::uintptr_t&>; }) {
+        return i.value();  // tsl::hopscotch_map iterators only expose a const 'second'
+    }
+    else {
+        return i->second;
+    }
+}
+
+/**
+ * look up a key with a single probe if \a Hash provides \a find()
+ * @return value stored for \a key or \a 0 if absent (stored values are never null)
+ */
+template <typename Hash, typename Key>
+std::uintptr_t map_lookup(const Hash& hash, const Key& key) {
+    if constexpr (MapFindGeneric<Hash, Key, std::uintptr_t>) {
+        auto i = hash.find(key);
+        return i != hash.end() ? static_cast<std::uintptr_t>(i->second) : 0;
+    }
+    else {
+        return hash.contains(key) ? static_cast<std::uintptr_t>(hash.at(key)) : 0;
+    }
+}
+
+/**
+ * start loading the memory a lookup of \a key touches first if \a Hash supports \a prefetch() (e.g.
+ * \a yfast::internal::FlatMap or \a absl::flat_hash_map); no-op otherwise
+ */
+template <typename Hash, typename Key>
+void map_prefetch(const Hash& hash, const Key& key) {
+    if constexpr (requires { hash.prefetch(key); }) {
+        hash.prefetch(key);
+    }
+}
+
+/**
+ * update an existing entry in place with a single probe if \a Hash allows erasing by iterator
+ * @param key key; undefined behavior if absent
+ * @param update callable taking the stored value by mutable reference; returns \a false to erase the entry
+ */
+template <typename Hash, typename Key, typename Update>
+void map_modify(Hash& hash, const Key& key, Update&& update) {
+    if constexpr (MapEraseGeneric<Hash, Key, std::uintptr_t>) {
+        auto i = hash.find(key);
+        if (!update(iterator_value(i))) {
+            hash.erase(i);
+        }
+    }
+    else {
+        if (!update(hash[key])) {
+            hash.erase(key);
+        }
+    }
+}
+
+/**
+ * x-fast trie level storage: a separate \a Hash per level
+ * @tparam ShiftResult shifted key type
+ * @tparam H key length in bits
+ * @tparam Hash map from shifted keys to \a std::uintptr_t
+ */
+template <typename ShiftResult, unsigned int H, typename Hash>
+class PerLevelStorage {
+    Hash _hash[H];
+
+public:
+    PerLevelStorage() = default;
+
+    /**
+     * @param alloc allocator for the maps (see \a yfast::internal::make_hash())
+     */
+    template <typename Allocator>
+    explicit PerLevelStorage(const Allocator& alloc): PerLevelStorage(alloc, std::make_index_sequence<H>()) {}
+
+    /**
+     * @return the number of entries at level \a 0 (i.e. the number of leaves)
+     */
+    [[nodiscard]] std::size_t size() const { return _hash[0].size(); }
+
+    /**
+     * look up a shifted key with a single probe if \a Hash provides \a find()
+     * @param h level
+     * @param key_prefix shifted key
+     * @return value stored for \a key_prefix at level \a h or \a 0 if absent (stored values are never null)
+     */
+    std::uintptr_t lookup(unsigned int h, const ShiftResult& key_prefix) const {
+        return map_lookup(_hash[h], key_prefix);
+    }
+
+    void prefetch(unsigned int h, const ShiftResult& key_prefix) const {
+        map_prefetch(_hash[h], key_prefix);
+    }
+
+    /**
+     * @param h level
+     * @param key_prefix shifted key
+     * @return mutable reference to the value stored for \a key_prefix at level \a h; zero if just inserted
+     */
+    std::uintptr_t& entry(unsigned int h, const ShiftResult& key_prefix) {
+        return _hash[h][key_prefix];
+    }
+
+    void erase(unsigned int h, const ShiftResult& key_prefix) {
+        _hash[h].erase(key_prefix);
+    }
+
+    /**
+     * update an existing entry in place with a single probe if \a Hash allows erasing by iterator
+     * @param h level
+     * @param key_prefix shifted key; undefined behavior if absent
+     * @param update callable taking the stored value by mutable reference; returns \a false to erase the entry
+     */
+    template <typename Update>
+    void modify(unsigned int h, const ShiftResult& key_prefix, Update&& update) {
+        map_modify(_hash[h], key_prefix, std::forward<Update>(update));
+    }
+
+    /**
+     * allocate room for \a n leaves if \a Hash supports \a reserve()
+     * @param n expected number of leaves
+     */
+    void reserve(std::size_t n) {
+        if constexpr (requires (Hash hash) { hash.reserve(n); }) {
+            for (unsigned int h = 0; h < H; ++h) {
+                _hash[h].reserve(level_capacity<H>(h, n));
+            }
+        }
+    }
+
+    void clear() {
+        for (unsigned int h = 0; h < H; ++h) {
+            _hash[h].clear();
+        }
+    }
+
+private:
+    template <typename Allocator, std::size_t... I>
+    PerLevelStorage(const Allocator& alloc, std::index_sequence<I...>): _hash { ((void) I, make_hash<Hash>(alloc))... } {}
+};
+
+/**
+ * (level, shifted key) pair used as a key of the unified level table
+ */
+template <typename ShiftResult, typename = void>
+struct LevelKey {
+    typedef std::pair<unsigned int, ShiftResult> Type;
+
+    struct Hash {
+        std::size_t operator () (const Type& key) const noexcept {
+            return std::hash<ShiftResult>()(key.second) ^ prefix_mix(key.first);
+        }
+    };
+
+    static Type make(unsigned int h, const ShiftResult& key_prefix) { return { h, key_prefix }; }
+};
+
+// levels fit into the upper half of a single 64-bit word
+template <typename ShiftResult>
+struct LevelKey<ShiftResult, std::enable_if_t<is_integral_v<ShiftResult> && sizeof(ShiftResult) <= sizeof(std::uint32_t)>> {
+    typedef std::uint64_t Type;
+    typedef PrefixHash<std::uint64_t> Hash;
+
+    static Type make(unsigned int h, ShiftResult key_prefix) {
+        return (static_cast<std::uint64_t>(h) << 32) | static_cast<make_unsigned_t<ShiftResult>>(key_prefix);
+    }
+};
+
+template <typename ShiftResult>
+struct LevelKey<ShiftResult, std::enable_if_t<is_integral_v<ShiftResult> && (sizeof(ShiftResult) > sizeof(std::uint32_t))>> {
+    struct Type {
+        ShiftResult prefix;
+        unsigned int level;
+
+        bool operator == (const Type& other) const = default;
+    };
+
+    // a prefix at level h has (at least) h leading zero bits, so the level (below 256) mostly lands in unused bits
+    struct Hash {
+        std::uint64_t operator () (const Type& key) const noexcept {
+            typedef make_unsigned_t<ShiftResult> Prefix;
+            constexpr auto shift = 8 * sizeof(ShiftResult) - 8;
+            return PrefixHash<Prefix>()(static_cast<Prefix>(key.prefix) ^ (static_cast<Prefix>(key.level) << shift));
+        }
+    };
+
+    static Type make(unsigned int h, ShiftResult key_prefix) { return { key_prefix, h }; }
+};
+
+template <typename ShiftResult, typename = void>
+struct DefaultLevelHashSelector {
+#ifdef YFAST_WITH_HOPSCOTCH_MAP
+    typedef tsl::hopscotch_map<typename LevelKey<ShiftResult>::Type, std::uintptr_t, typename LevelKey<ShiftResult>::Hash> Type;
+#else
+    typedef std::unordered_map<typename LevelKey<ShiftResult>::Type, std::uintptr_t, typename LevelKey<ShiftResult>::Hash> Type;
+#endif
+};
+
+template <typename ShiftResult>
+struct DefaultLevelHashSelector<ShiftResult, std::enable_if_t<is_integral_v<ShiftResult>>> {
+    typedef FlatMap<typename LevelKey<ShiftResult>::Type, std::uintptr_t, typename LevelKey<ShiftResult>::Hash> Type;
+};
+
+/**
+ * \a yfast::internal::FlatMap for integral shifted keys; otherwise \a tsl::hopscotch_map if available or
+ * \a std::unordered_map
+ */
+template <typename ShiftResult>
+using DefaultLevelHash = typename DefaultLevelHashSelector<ShiftResult>::Type;
+
+/**
+ * x-fast trie level storage: a single \a Hash keyed by (level, shifted key) pairs for all the levels, i.e. a single
+ * allocation and a single load factor instead of \a H of each
+ * @tparam ShiftResult shifted key type
+ * @tparam H key length in bits
+ * @tparam Hash map from \a yfast::internal::LevelKey to \a std::uintptr_t
+ */
+template <typename ShiftResult, unsigned int H, typename Hash = DefaultLevelHash<ShiftResult>>
+class UnifiedStorage {
+    typedef LevelKey<ShiftResult> Key;
+
+    Hash _hash;
+    std::size_t _size = 0;
+
+public:
+    UnifiedStorage() = default;
+
+    /**
+     * @param alloc allocator for the map (see \a yfast::internal::make_hash())
+     */
+    template <typename Allocator>
+    explicit UnifiedStorage(const Allocator& alloc): _hash(make_hash<Hash>(alloc)) {}
+
+    UnifiedStorage(UnifiedStorage&& other) noexcept: _hash(std::move(other._hash)), _size(other._size) {
+        other._size = 0;
+    }
+
+    /**
+     * @return the number of entries at level \a 0 (i.e. the number of leaves)
+     */
+    [[nodiscard]] std::size_t size() const { return _size; }
+
+    /**
+     * @param h level
+     * @param key_prefix shifted key
+     * @return value stored for \a key_prefix at level \a h or \a 0 if absent (stored values are never null)
+     */
+    std::uintptr_t lookup(unsigned int h, const ShiftResult& key_prefix) const {
+        return map_lookup(_hash, Key::make(h, key_prefix));
+    }
+
+    void prefetch(unsigned int h, const ShiftResult& key_prefix) const {
+        map_prefetch(_hash, Key::make(h, key_prefix));
+    }
+
+    /**
+     * @param h level
+     * @param key_prefix shifted key
+     * @return mutable reference to the value stored for \a key_prefix at level \a h; zero if just inserted
+     */
+    std::uintptr_t& entry(unsigned int h, const ShiftResult& key_prefix) {
+        auto& value = _hash[Key::make(h, key_prefix)];
+        if (h == 0 && value == 0) {
+            ++_size;  // the caller stores a leaf right away
+        }
+        return value;
+    }
+
+    void erase(unsigned int h, const ShiftResult& key_prefix) {
+        if (_hash.erase(Key::make(h, key_prefix)) && h == 0) {
+            --_size;
+        }
+    }
+
+    /**
+     * update an existing entry in place with a single probe if \a Hash allows erasing by iterator
+     * @param h level other than \a 0
+     * @param key_prefix shifted key; undefined behavior if absent
+     * @param update callable taking the stored value by mutable reference; returns \a false to erase the entry
+     */
+    template <typename Update>
+    void modify(unsigned int h, const ShiftResult& key_prefix, Update&& update) {
+        map_modify(_hash, Key::make(h, key_prefix), std::forward<Update>(update));
+    }
+
+    /**
+     * allocate room for the nodes of \a n leaves if \a Hash supports \a reserve()
+     * @param n expected number of leaves
+     */
+    void reserve(std::size_t n) {
+        if constexpr (requires (Hash hash) { hash.reserve(n); }) {
+            std::size_t total = 0;
+            for (unsigned int h = 0; h < H; ++h) {
+                total += level_capacity<H>(h, n);
+            }
+            _hash.reserve(total);
+        }
+    }
+
+    void clear() {
+        _hash.clear();
+        _size = 0;
+    }
+};
+
+/**
+ * \a Hash template parameter selecting \a yfast::internal::UnifiedStorage
+ * @tparam Hash map from \a yfast::internal::LevelKey to \a std::uintptr_t; \a void for the default one
+ */
+template <typename Hash = void>
+struct UnifiedLevels {
+    template <typename ShiftResult, unsigned int H, typename Allocator = std::allocator<std::uintptr_t>>
+    using Storage = UnifiedStorage<ShiftResult, H, std::conditional_t<std::is_void_v<Hash>, typename RebindHash<DefaultLevelHash<ShiftResult>, Allocator>::Type, Hash>>;
+};
+
+/**
+ * x-fast trie level storage: direct-indexed arrays for the top \a K levels (level \a h holds at most 2^(H-h)
+ * prefixes, so the prefix itself is the index) and a separate \a Hash per level below them \n
+ * the arrays take 2^(K+1) words in total and are allocated on the first insert
+ * @tparam ShiftResult integral shifted key type
+ * @tparam H key length in bits
+ * @tparam Hash map from shifted keys to \a std::uintptr_t
+ * @tparam K number of direct-indexed levels
+ * @tparam Allocator allocator of the arrays
+ */
+template <
+    typename ShiftResult,
+    unsigned int H,
+    typename Hash,
+    unsigned int K = std::min(16U, H / 2),
+    typename Allocator = std::allocator<std::uintptr_t>
+>
+class DirectTopStorage {
+    static_assert(is_integral_v<ShiftResult>, "Integral shifted keys required");
+    static_assert(K < H && K < 8 * sizeof(std::size_t), "Too many direct-indexed levels");
+
+    static constexpr unsigned int HASHED = H - K;
+    static constexpr std::size_t TOP_SIZE = (std::size_t{1} << (K + 1)) - 2;
+
+    typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::uintptr_t> TopAlloc;
+
+    struct TopDeleter {
+        TopAlloc alloc;
+
+        void operator () (std::uintptr_t* top) {
+            std::allocator_traits<TopAlloc>::deallocate(alloc, top, TOP_SIZE);
+        }
+    };
+
+    Hash _hash[HASHED];
+    std::unique_ptr<std::uintptr_t[], TopDeleter> _top;
+
+public:
+    DirectTopStorage() = default;
+
+    /**
+     * @param alloc allocator for the arrays and the maps (see \a yfast::internal::make_hash())
+     */
+    explicit DirectTopStorage(const Allocator& alloc): DirectTopStorage(alloc, std::make_index_sequence<HASHED>()) {}
+
+    /**
+     * @return the number of entries at level \a 0 (i.e. the number of leaves)
+     */
+    [[nodiscard]] std::size_t size() const { return _hash[0].size(); }
+
+    /**
+     * @param h level
+     * @param key_prefix shifted key
+     * @return value stored for \a key_prefix at level \a h or \a 0 if absent (stored values are never null)
+     */
+    std::uintptr_t lookup(unsigned int h, const ShiftResult& key_prefix) const {
+        if (h < HASHED) {
+            return map_lookup(_hash[h], key_prefix);
+        }
+        return _top ? _top[index(h, key_prefix)] : 0;
+    }
+
+    void prefetch(unsigned int h, const ShiftResult& key_prefix) const {
+        if (h < HASHED) {
+            map_prefetch(_hash[h], key_prefix);
+        }
+        else if (_top) {
+            utils::prefetch(&_top[index(h, key_prefix)]);
+        }
+    }
+
+    /**
+     * @param h level
+     * @param key_prefix shifted key
+     * @return mutable reference to the value stored for \a key_prefix at level \a h; zero if just inserted
+     */
+    std::uintptr_t& entry(unsigned int h, const ShiftResult& key_prefix) {
+        if (h < HASHED) {
+            return _hash[h][key_prefix];
+        }
+        if (!_top) {
+            allocate_top();
+        }
+        return _top[index(h, key_prefix)];
+    }
+
+    void erase(unsigned int h, const ShiftResult& key_prefix) {
+        if (h < HASHED) {
+            _hash[h].erase(key_prefix);
+        }
+        else {
+            _top[index(h, key_prefix)] = 0;
+        }
+    }
+
+    /**
+     * update an existing entry in place
+     * @param h level
+     * @param key_prefix shifted key; undefined behavior if absent
+     * @param update callable taking the stored value by mutable reference; returns \a false to erase the entry
+     */
+    template <typename Update>
+    void modify(unsigned int h, const ShiftResult& key_prefix, Update&& update) {
+        if (h < HASHED) {
+            map_modify(_hash[h], key_prefix, std::forward<Update>(update));
+        }
+        else {
+            auto& value = _top[index(h, key_prefix)];
+            if (!update(value)) {
+                value = 0;
+            }
+        }
+    }
+
+    /**
+     * allocate room for \a n leaves (hashed levels only if \a Hash supports \a reserve())
+     * @param n expected number of leaves
+     */
+    void reserve(std::size_t n) {
+        if constexpr (requires (Hash hash) { hash.reserve(n); }) {
+            for (unsigned int h = 0; h < HASHED; ++h) {
+                _hash[h].reserve(level_capacity<H>(h, n));
+            }
+        }
+        if (n > 0 && !_top) {
+            allocate_top();
+        }
+    }
+
+    void clear() {
+        for (unsigned int h = 0; h < HASHED; ++h) {
+            _hash[h].clear();
+        }
+        _top.reset();
+    }
+
+private:
+    template <std::size_t... I>
+    DirectTopStorage(const Allocator& alloc, std::index_sequence<I...>): _hash { ((void) I, make_hash<Hash>(alloc))... }, _top(nullptr, TopDeleter { TopAlloc(alloc) }) {}
+
+    void allocate_top() {
+        auto top = std::allocator_traits<TopAlloc>::allocate(_top.get_deleter().alloc, TOP_SIZE);
+        std::fill_n(top, TOP_SIZE, std::uintptr_t{0});
+        _top.reset(top);
+    }
+
+    // level h takes 2^(H-h) words at offset 2^(H-h) - 2, i.e. the root's children come first
+    static std::size_t index(unsigned int h, ShiftResult key_prefix) {
+        const auto size = std::size_t{1} << (H - h);
+        return size - 2 + (static_cast<std::size_t>(static_cast<make_unsigned_t<ShiftResult>>(key_prefix)) & (size - 1));
+    }
+};
+
+/**
+ * \a Hash template parameter selecting \a yfast::internal::DirectTopStorage
+ * @tparam Hash map from shifted keys to \a std::uintptr_t for the hashed levels; \a void for the default one
+ */
+template <typename Hash = void>
+struct DirectTopLevels {
+    template <typename ShiftResult, unsigned int H, typename Allocator = std::allocator<std::uintptr_t>>
+    using Storage = DirectTopStorage<
+        ShiftResult,
+        H,
+        std::conditional_t<std::is_void_v<Hash>, typename RebindHash<DefaultHash<ShiftResult, std::uintptr_t>, Allocator>::Type, Hash>,
+        std::min(16U, H / 2),
+        Allocator
+    >;
+};
+
+template <typename Hash, typename ShiftResult, unsigned int H, typename Allocator>
+struct LevelStorageSelector {
+    typedef PerLevelStorage<ShiftResult, H, typename RebindHash<Hash, Allocator>::Type> Type;
+};
+
+template <typename Hash, typename ShiftResult, unsigned int H, typename Allocator> requires LevelPolicyGeneric<Hash, ShiftResult>
+struct LevelStorageSelector<Hash, ShiftResult, H, Allocator> {
+    typedef typename Hash::template Storage<ShiftResult, H> Type;
+};
+
+template <typename Hash, typename ShiftResult, unsigned int H, typename Allocator> requires LevelPolicyGeneric<Hash, ShiftResult> && requires { typename Hash::template Storage<ShiftResult, H, Allocator>; }
+struct LevelStorageSelector<Hash, ShiftResult, H, Allocator> {
+    typedef typename Hash::template Storage<ShiftResult, H, Allocator> Type;
+};
+
+/**
+ * \a yfast::internal::PerLevelStorage if \a Hash is a map, with \a Allocator substituted for the default allocator
+ * of the default maps (see \a yfast::internal::RebindHash); otherwise the storage \a Hash policy provides, given
+ * \a Allocator if it takes one
+ */
+template <typename Hash, typename ShiftResult, unsigned int H, typename Allocator = std::allocator<std::uintptr_t>>
+using LevelStorage = typename LevelStorageSelector<Hash, ShiftResult, H, Allocator>::Type;
+
+}
+
+#endif
@@ -0,0 +1,170 @@
+#ifndef _YFAST_INTERNAL_SIMD_SEARCH_H
+#define _YFAST_INTERNAL_SIMD_SEARCH_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#include <immintrin.h>
+#define YFAST_SIMD_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define YFAST_SIMD_NEON 1
+#endif
+
+// AVX2 kernels are compiled for any x86 target GCC and clang build, and picked at run time unless AVX2 (or AVX-512)
+// is enabled at compile time
+#if defined(YFAST_SIMD_X86) && !defined(__AVX2__) && (defined(__GNUC__) || defined(__clang__))
+#define YFAST_SIMD_AVX2_DISPATCH 1
+#endif
+
+#include <yfast/internal/integral.h>
+
+namespace yfast::internal {
+
+/**
+ * whether \a count_less() has vector kernels for \a Key: 32- and 64-bit integers
+ */
+template <typename Key>
+constexpr bool simd_searchable_v = is_integral_v<Key> && (sizeof(Key) == sizeof(std::uint32_t) || sizeof(Key) == sizeof(std::uint64_t));
+
+namespace simd {
+
+template <typename Key>
+std::size_t count_less_scalar(const Key* keys, std::size_t n, Key key) {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        count += keys[i] < key;
+    }
+    return count;
+}
+
+#if defined(YFAST_SIMD_X86) && defined(__AVX512F__)
+template <typename Key>
+std::size_t count_less_avx512(const Key* keys, std::size_t n, Key key) {
+    constexpr std::size_t W = sizeof(__m512i) / sizeof(Key);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    if constexpr (sizeof(Key) == sizeof(std::uint64_t)) {
+        const auto k = _mm512_set1_epi64(static_cast<long long>(key));
+        for (; i + W <= n; i += W) {
+            const auto v = _mm512_loadu_si512(keys + i);
+            const auto lt = is_signed_v<Key> ? _mm512_cmplt_epi64_mask(v, k) : _mm512_cmplt_epu64_mask(v, k);
+            count += std::popcount(static_cast<unsigned int>(lt));
+        }
+    }
+    else {
+        const auto k = _mm512_set1_epi32(static_cast<int>(key));
+        for (; i + W <= n; i += W) {
+            const auto v = _mm512_loadu_si512(keys + i);
+            const auto lt = is_signed_v<Key> ? _mm512_cmplt_epi32_mask(v, k) : _mm512_cmplt_epu32_mask(v, k);
+            count += std::popcount(static_cast<unsigned int>(lt));
+        }
+    }
+    return count + count_less_scalar(keys + i, n - i, key);
+}
+#endif
+
+#if defined(YFAST_SIMD_X86) && (defined(__AVX2__) || defined(YFAST_SIMD_AVX2_DISPATCH))
+// AVX2 only compares signed numbers, so unsigned ones get their sign bits flipped first
+template <typename Key>
+#ifdef YFAST_SIMD_AVX2_DISPATCH
+__attribute__((target("avx2")))
+#endif
+std::size_t count_less_avx2(const Key* keys, std::size_t n, Key key) {
+    constexpr std::size_t W = sizeof(__m256i) / sizeof(Key);
+    std::size_t count = 0;
+    std::size_t i = 0;
+    if constexpr (sizeof(Key) == sizeof(std::uint64_t)) {
+        const auto bias = _mm256_set1_epi64x(is_signed_v<Key> ? 0 : INT64_MIN);
+        const auto k = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(key)), bias);
+        for (; i + W <= n; i += W) {
+            const auto v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), bias);
+            const auto lt = _mm256_cmpgt_epi64(k, v);
+            count += std::popcount(static_cast<unsigned int>(_mm256_movemask_pd(_mm256_castsi256_pd(lt))));
+        }
+    }
+    else {
+        const auto bias = _mm256_set1_epi32(is_signed_v<Key> ? 0 : INT32_MIN);
+        const auto k = _mm256_xor_si256(_mm256_set1_epi32(static_cast<int>(key)), bias);
+        for (; i + W <= n; i += W) {
+            const auto v = _mm256_xor_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys + i)), bias);
+            const auto lt = _mm256_cmpgt_epi32(k, v);
+            count += std::popcount(static_cast<unsigned int>(_mm256_movemask_ps(_mm256_castsi256_ps(lt))));
+        }
+    }
+    return count + count_less_scalar(keys + i, n - i, key);
+}
+#endif
+
+#ifdef YFAST_SIMD_NEON
+// lanes that compare less are all ones, i.e. -1, so subtracting them counts them
+template <typename Key>
+std::size_t count_less_neon(const Key* keys, std::size_t n, Key key) {
+    std::size_t i = 0;
+    std::size_t count = 0;
+    if constexpr (sizeof(Key) == sizeof(std::uint64_t)) {
+        constexpr std::size_t W = 2;
+        auto acc = vdupq_n_u64(0);
+        for (; i + W <= n; i += W) {
+            uint64x2_t lt;
+            if constexpr (is_signed_v<Key>) {
+                lt = vcltq_s64(vld1q_s64(reinterpret_cast<const std::int64_t*>(keys + i)), vdupq_n_s64(key));
+            }
+            else {
+                lt = vcltq_u64(vld1q_u64(reinterpret_cast<const std::uint64_t*>(keys + i)), vdupq_n_u64(key));
+            }
+            acc = vsubq_u64(acc, lt);
+        }
+        count = vaddvq_u64(acc);
+    }
+    else {
+        constexpr std::size_t W = 4;
+        auto acc = vdupq_n_u32(0);
+        for (; i + W <= n; i += W) {
+            uint32x4_t lt;
+            if constexpr (is_signed_v<Key>) {
+                lt = vcltq_s32(vld1q_s32(reinterpret_cast<const std::int32_t*>(keys + i)), vdupq_n_s32(key));
+            }
+            else {
+                lt = vcltq_u32(vld1q_u32(reinterpret_cast<const std::uint32_t*>(keys + i)), vdupq_n_u32(key));
+            }
+            acc = vsubq_u32(acc, lt);
+        }
+        count = vaddvq_u32(acc);
+    }
+    return count + count_less_scalar(keys + i, n - i, key);
+}
+#endif
+
+}
+
+/**
+ * the number of keys less than \a key, i.e. the position of \a key within sorted \a keys, counted with vector
+ * compares and popcounts: AVX-512 or AVX2 (selected at compile time if enabled, otherwise AVX2 is picked at run time
+ * if supported) on x86, NEON on ARM64 and a scalar loop elsewhere
+ * @param keys keys (sorted or not)
+ * @param n number of keys
+ */
+template <typename Key>
+std::size_t count_less(const Key* keys, std::size_t n, Key key) {
+    static_assert(simd_searchable_v<Key>, "32- or 64-bit integral key required");
+#if defined(YFAST_SIMD_X86) && defined(__AVX512F__)
+    return simd::count_less_avx512(keys, n, key);
+#elif defined(YFAST_SIMD_X86) && defined(__AVX2__)
+    return simd::count_less_avx2(keys, n, key);
+#elif defined(YFAST_SIMD_AVX2_DISPATCH)
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2 ? simd::count_less_avx2(keys, n, key) : simd::count_less_scalar(keys, n, key);
+#elif defined(YFAST_SIMD_NEON)
+    return simd::count_less_neon(keys, n, key);
+#else
+    return simd::count_less_scalar(keys, n, key);
+#endif
+}
+
+}
+
+#endif
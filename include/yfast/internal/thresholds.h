@@ -0,0 +1,106 @@
+#ifndef _YFAST_INTERNAL_THRESHOLDS_H
+#define _YFAST_INTERNAL_THRESHOLDS_H
+
+#include <algorithm>
+#include <cstddef>
+
+namespace yfast::internal {
+
+/**
+ * bucket split/merge thresholds fixed at compile time
+ * @tparam Split a bucket holding more leaves is split in two
+ * @tparam Merge a bucket holding fewer leaves is merged with a neighbor
+ */
+template <unsigned int Split, unsigned int Merge>
+struct StaticThresholds {
+    static_assert(Merge > 0 && 2 * Merge <= Split, "Bucket halves must not be merged right after a split");
+
+    static constexpr unsigned int MAX_SPLIT = Split;
+    static constexpr unsigned int MAX_MERGE = Merge;
+
+    static constexpr unsigned int split() { return Split; }
+    static constexpr unsigned int merge() { return Merge; }
+};
+
+/**
+ * \a Thresholds template parameter: buckets are split above 2H leaves and merged below H/4
+ */
+struct DefaultThresholds {
+    template <unsigned int H>
+    using Thresholds = StaticThresholds<2 * H, H / 4>;
+};
+
+/**
+ * \a Thresholds template parameter: buckets are split above \a Split leaves and merged below \a Merge regardless of
+ * the key length
+ */
+template <unsigned int Split, unsigned int Merge>
+struct FixedThresholds {
+    template <unsigned int H>
+    using Thresholds = StaticThresholds<Split, Merge>;
+};
+
+/**
+ * \a Thresholds template parameter: the split threshold starts at 2H and is doubled or halved (within a factor of
+ * \a Range either way) at the end of every epoch, depending on which of the two costs observed over the epoch
+ * outweighs the other by more than twice: x-fast trie rebuilds (which bigger buckets make rarer) or bucket searches
+ * (which smaller buckets make a node visit shorter); the merge threshold follows at one eighth of the split one \n
+ * thresholds only change what the following updates do, so existing buckets are resized lazily; an epoch lasts at
+ * least as many updates as there are leaves, so that splits and merges coming in waves (as uniformly spread updates
+ * fill or drain all the buckets at once) are averaged out along with the resizing; bucket capacity is sized for the
+ * largest threshold
+ * @tparam Range how far the split threshold may depart from 2H
+ * @tparam Epoch minimal number of updates between adjustments
+ */
+template <unsigned int Range = 4, unsigned int Epoch = 4096>
+struct AdaptiveThresholds {
+    static_assert(Range > 0 && Epoch > 0, "Range and epoch must be positive");
+
+    template <unsigned int H>
+    class Thresholds {
+        static constexpr unsigned int MIN_SPLIT = std::max(2 * H / Range, 16U);
+        // a rebuild rewrites H level table entries for each of the two or three x-fast trie leaves it moves, each
+        // update (hashing, probing, occasionally rehashing) costing several times a bucket node visit
+        static constexpr std::size_t REBUILD_COST = 16 * H;
+
+    public:
+        static constexpr unsigned int MAX_SPLIT = 2 * H * Range;
+        static constexpr unsigned int MAX_MERGE = MAX_SPLIT / 8;
+
+    private:
+        unsigned int _split = 2 * H;
+        unsigned int _rebuilds = 0;
+        std::size_t _updates = 0;
+
+    public:
+        [[nodiscard]] unsigned int split() const { return _split; }
+        [[nodiscard]] unsigned int merge() const { return _split / 8; }
+
+        /**
+         * count an update, which takes a bucket search, and adjust the thresholds at the end of an epoch
+         * @param rebuilds the trie rebuild count so far
+         * @param size the number of leaves in the trie
+         */
+        void on_update(unsigned int rebuilds, std::size_t size) {
+            if (++_updates < std::max<std::size_t>(Epoch, size)) {
+                return;
+            }
+            // doubling the buckets saves half the rebuilds at the cost of one more node visit per bucket search,
+            // halving them saves that visit at the cost of as many rebuilds again
+            const auto rebuild_cost = (rebuilds - _rebuilds) * REBUILD_COST;
+            const auto search_cost = _updates;
+            if (rebuild_cost > 2 * search_cost && _split < MAX_SPLIT) {
+                _split *= 2;
+            }
+            else if (search_cost > 2 * rebuild_cost && _split / 2 >= MIN_SPLIT) {
+                _split /= 2;
+            }
+            _rebuilds = rebuilds;
+            _updates = 0;
+        }
+    };
+};
+
+}
+
+#endif
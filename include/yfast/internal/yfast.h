@@ -1,17 +1,26 @@
 #ifndef _YFAST_INTERNAL_YFAST_H
 #define _YFAST_INTERNAL_YFAST_H
 
+#include <type_traits>
 #include <utility>
 
 #include <yfast/impl/xfast.h>
 
 namespace yfast::internal {
 
+/**
+ * x-fast trie leaf holding a y-fast trie bucket along with pointers to its minimal and maximal leaves, so that
+ * routing between neighboring buckets only touches the x-fast trie leaves
+ */
 template <typename Key, typename Value>
 struct XFastLeaf: public XFastLeafBase<Key, XFastLeaf<Key, Value>> {
+    typedef std::remove_pointer_t<decltype(std::declval<const Value&>().leftmost())> Leaf;
+
+    Leaf* min;
+    Leaf* max;
     Value value;
 
-    explicit XFastLeaf(const Key& key, Value&& value): XFastLeafBase<Key, XFastLeaf>(key), value(std::move(value)) {}
+    explicit XFastLeaf(const Key& key, Value&& value): XFastLeafBase<Key, XFastLeaf>(key), min(value.leftmost()), max(value.rightmost()), value(std::move(value)) {}
 };
 
 }
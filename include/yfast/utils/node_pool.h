@@ -0,0 +1,160 @@
+#ifndef _YFAST_UTILS_NODE_POOL_H
+#define _YFAST_UTILS_NODE_POOL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define YFAST_NODE_POOL_MMAP 1
+#endif
+
+namespace yfast::utils {
+
+/**
+ * process-wide pool of nodes of type \a T addressed by 32-bit indices, so that nodes may link to each other with
+ * indices rather than pointers \n
+ * the pool reserves address space for \a CAPACITY nodes at once (POSIX only) and commits it as it grows, so nodes
+ * never move; freed nodes are reused but their memory is not returned to the system \n
+ * index 0 stands for \a nullptr
+ */
+template <typename T>
+class NodePool {
+public:
+    /**
+     * maximal number of nodes; indices leave a bit spare (see \a pool_ptr)
+     */
+    static constexpr std::uint32_t CAPACITY = std::uint32_t{1} << 31;
+
+private:
+    static_assert(sizeof(T) >= sizeof(std::uint32_t), "Node too small to be pooled");
+
+    static constexpr std::size_t COMMIT_CHUNK = std::size_t{1} << 21;
+
+    inline static T* _base = nullptr;
+    inline static std::size_t _committed = 0;
+    inline static std::uint32_t _top = 1;
+    inline static std::uint32_t _free = 0;
+    inline static std::mutex _mutex;
+
+public:
+    /**
+     * @return pointer to the node at \a index or \a nullptr if \a index is 0
+     */
+    static T* get(std::uint32_t index) { return index != 0 ? _base + index : nullptr; }
+
+    /**
+     * @return index of the node at \a ptr (allocated from the pool) or 0 if \a ptr is \a nullptr
+     */
+    static std::uint32_t index(const T* ptr) { return ptr != nullptr ? static_cast<std::uint32_t>(ptr - _base) : 0; }
+
+    /**
+     * @return uninitialized memory for a node
+     * @throw std::bad_alloc if the pool is exhausted or address space cannot be reserved or committed
+     */
+    static T* allocate() {
+        std::lock_guard lock(_mutex);
+        if (_free != 0) {
+            auto ptr = _base + _free;
+            std::memcpy(&_free, static_cast<void*>(ptr), sizeof(_free));
+            return ptr;
+        }
+        if (_top == CAPACITY) {
+            throw std::bad_alloc();
+        }
+        const auto end = (static_cast<std::size_t>(_top) + 1) * sizeof(T);
+        if (end > _committed) {
+            commit(end);
+        }
+        return _base + _top++;
+    }
+
+    /**
+     * give back the memory of a destroyed node
+     * @param ptr pointer returned by \a allocate()
+     */
+    static void deallocate(T* ptr) {
+        std::lock_guard lock(_mutex);
+        std::memcpy(static_cast<void*>(ptr), &_free, sizeof(_free));
+        _free = index(ptr);
+    }
+
+private:
+    static void commit(std::size_t end) {
+#ifdef YFAST_NODE_POOL_MMAP
+        constexpr auto reserved = static_cast<std::size_t>(CAPACITY) * sizeof(T);
+        if (_base == nullptr) {
+            auto ptr = ::mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (ptr == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            _base = static_cast<T*>(ptr);
+        }
+        const auto committed = std::min((end + COMMIT_CHUNK - 1) / COMMIT_CHUNK * COMMIT_CHUNK, reserved);
+        if (::mprotect(reinterpret_cast<char*>(_base) + _committed, committed - _committed, PROT_READ | PROT_WRITE) != 0) {
+            throw std::bad_alloc();
+        }
+        _committed = committed;
+#else
+        static_assert(!std::is_same_v<T, T>, "Node pools require POSIX virtual memory");
+#endif
+    }
+};
+
+/**
+ * stateless allocator of single nodes from \a NodePool<T>
+ */
+template <typename T>
+struct NodePoolAllocator {
+    typedef T value_type;
+
+    NodePoolAllocator() = default;
+
+    /**
+     * nodes never come from other allocators, so any allocator converts
+     */
+    template <typename Allocator>
+    NodePoolAllocator(const Allocator&) {}
+
+    T* allocate(std::size_t n) {
+        if (n != 1) {
+            throw std::bad_alloc();
+        }
+        return NodePool<T>::allocate();
+    }
+
+    void deallocate(T* ptr, std::size_t) { NodePool<T>::deallocate(ptr); }
+
+    template <typename U>
+    bool operator==(const NodePoolAllocator<U>&) const { return true; }
+};
+
+/**
+ * \a aligned_ptr counterpart holding a \a NodePool<T> index along with \a N bits in a 32-bit word
+ */
+template <unsigned int N, typename T>
+struct pool_ptr {
+    static constexpr std::uint32_t BIT_MASK = (std::uint32_t{1} << N) - 1;
+
+    std::uint32_t value;
+
+    pool_ptr(std::uint32_t value): value(value) {}
+
+    explicit pool_ptr(T* ptr = nullptr): value(NodePool<T>::index(ptr) << N) {}
+
+    T* get_ptr() const { return NodePool<T>::get(value >> N); }
+    [[nodiscard]] bool get_bit(unsigned int n) const { return value & (std::uint32_t{1} << n); }
+
+    void set_ptr(T* ptr) { value = NodePool<T>::index(ptr) << N | (value & BIT_MASK); }
+    void set_bit(unsigned int n) { value |= std::uint32_t{1} << n; }
+    void clear_bit(unsigned int n) { value &= ~(std::uint32_t{1} << n); }
+};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef _YFAST_UTILS_PAGES_H
+#define _YFAST_UTILS_PAGES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#define YFAST_HUGE_PAGES_MMAP 1
+#endif
+
+namespace yfast::utils {
+
+/**
+ * \a Pages template parameter of \a yfast::utils::BasicSlabResource: slabs come from the global heap
+ */
+struct HeapPages {
+    /**
+     * slab sizes are rounded up to a multiple of \a PAGE bytes
+     */
+    static constexpr std::size_t PAGE = std::size_t{1} << 12;
+
+    /**
+     * @return uninitialized memory of \a size bytes aligned to \a alignment
+     */
+    static void* allocate(std::size_t size, std::size_t alignment) {
+        return ::operator new(size, std::align_val_t(alignment));
+    }
+
+    static void deallocate(void* ptr, std::size_t, std::size_t alignment) {
+        ::operator delete(ptr, std::align_val_t(alignment));
+    }
+};
+
+/**
+ * \a Pages template parameter of \a yfast::utils::BasicSlabResource: slabs are mapped (POSIX only) at 2 MiB
+ * boundaries and in multiples of 2 MiB, and advised to be backed by transparent huge pages, so that random accesses
+ * over a big container take a TLB entry per 2 MiB rather than per 4 KiB \n
+ * the memory is backed by normal pages where transparent huge pages are unavailable or disabled, and comes from the
+ * global heap on other systems
+ */
+struct HugePages {
+    static constexpr std::size_t PAGE = std::size_t{1} << 21;
+
+    /**
+     * @return uninitialized memory of \a size bytes aligned to \a PAGE
+     * @throw std::bad_alloc if the memory cannot be mapped
+     */
+    static void* allocate(std::size_t size, [[maybe_unused]] std::size_t alignment) {
+#ifdef YFAST_HUGE_PAGES_MMAP
+        const auto bytes = round_up(size);
+        // map a spare page to trim down to the first 2 MiB boundary
+        auto ptr = ::mmap(nullptr, bytes + PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED) {
+            throw std::bad_alloc();
+        }
+        const auto base = reinterpret_cast<std::uintptr_t>(ptr);
+        const auto aligned = (base + PAGE - 1) & ~(PAGE - 1);
+        if (aligned > base) {
+            ::munmap(ptr, aligned - base);
+        }
+        ::munmap(reinterpret_cast<void*>(aligned + bytes), base + PAGE - aligned);
+#ifdef MADV_HUGEPAGE
+        ::madvise(reinterpret_cast<void*>(aligned), bytes, MADV_HUGEPAGE);  // normal pages if it fails
+#endif
+        return reinterpret_cast<void*>(aligned);
+#else
+        return HeapPages::allocate(size, alignment);
+#endif
+    }
+
+    static void deallocate(void* ptr, std::size_t size, [[maybe_unused]] std::size_t alignment) {
+#ifdef YFAST_HUGE_PAGES_MMAP
+        ::munmap(ptr, round_up(size));
+#else
+        HeapPages::deallocate(ptr, size, alignment);
+#endif
+    }
+
+private:
+    static std::size_t round_up(std::size_t size) { return (size + PAGE - 1) & ~(PAGE - 1); }
+};
+
+}
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef _YFAST_UTILS_PREFETCH_H
+#define _YFAST_UTILS_PREFETCH_H
+
+#if !defined(__GNUC__) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#endif
+
+namespace yfast::utils {
+
+/**
+ * hint the CPU to start loading the cache line at \a ptr; never faults
+ */
+inline void prefetch(const void* ptr) {
+#if defined(__GNUC__)
+    __builtin_prefetch(ptr);
+#elif defined(_M_X64) || defined(_M_IX86)
+    _mm_prefetch(static_cast<const char*>(ptr), _MM_HINT_T0);
+#else
+    (void) ptr;
+#endif
+}
+
+}
+
+#endif
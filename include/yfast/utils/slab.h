@@ -0,0 +1,235 @@
+#ifndef _YFAST_UTILS_SLAB_H
+#define _YFAST_UTILS_SLAB_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include <yfast/utils/pages.h>
+
+namespace yfast::utils {
+
+/**
+ * size-class slab memory: blocks of each size (rounded up to 8 bytes) are carved out of slabs of their own, and freed
+ * blocks are kept on a per-class free list for reuse; blocks too big to share a slab (such as hash table arrays) get a
+ * slab each, which is given back to the system as soon as the block is freed \n
+ * other slabs are only given back to the system all at once, by \a release() or by the destructor; not thread-safe
+ * @tparam Pages where slabs come from: \a yfast::utils::HeapPages or \a yfast::utils::HugePages
+ */
+template <typename Pages = HeapPages>
+class BasicSlabResource {
+    static constexpr std::size_t GRANULE = 8;
+    static constexpr std::size_t SMALL_CLASSES = 128;
+    // slab header, keeping the blocks cache line aligned
+    static constexpr std::size_t HEADER = 64;
+    static constexpr std::size_t MIN_SLAB = std::max(std::size_t{1} << 16, Pages::PAGE);
+    static constexpr std::size_t MAX_SLAB = std::max(std::size_t{1} << 22, Pages::PAGE);
+    // a slab holds at least 16 blocks
+    static constexpr std::size_t MAX_BLOCK = MAX_SLAB / 16;
+
+    struct Slab {
+        Slab* prev;
+        Slab* next;
+        std::size_t size;
+    };
+
+    static_assert(sizeof(Slab) <= HEADER, "Slab header too small");
+
+    struct SizeClass {
+        void* free = nullptr;
+        char* top = nullptr;
+        char* end = nullptr;
+        // slab sizes double up to MAX_SLAB, so that the number of slabs grows with the logarithm of small maps and
+        // linearly (but slowly) with big ones
+        std::size_t slab = MIN_SLAB;
+    };
+
+    SizeClass _small[SMALL_CLASSES];
+    std::vector<std::pair<std::size_t, SizeClass>> _large;
+    Slab* _slabs = nullptr;
+
+public:
+    /**
+     * maximal alignment of the blocks
+     */
+    static constexpr std::size_t MAX_ALIGNMENT = HEADER;
+
+    BasicSlabResource() = default;
+    BasicSlabResource(const BasicSlabResource& other) = delete;
+
+    ~BasicSlabResource() { release(); }
+
+    /**
+     * @param size block size; blocks are aligned to the greatest power of two (up to \a MAX_ALIGNMENT) that \a size,
+     * rounded up to 8, is a multiple of
+     * @return uninitialized block of \a size bytes
+     */
+    void* allocate(std::size_t size) {
+        const auto rounded = round_up(size);
+        if (rounded > MAX_BLOCK) {
+            return reinterpret_cast<char*>(new_slab(HEADER + rounded)) + HEADER;
+        }
+        auto& sc = size_class(rounded);
+        if (sc.free != nullptr) {
+            auto block = sc.free;
+            sc.free = *static_cast<void**>(block);
+            return block;
+        }
+        if (sc.top + rounded > sc.end) {
+            auto slab = new_slab(std::max(sc.slab, HEADER + 16 * rounded));
+            sc.top = reinterpret_cast<char*>(slab) + HEADER;
+            sc.end = reinterpret_cast<char*>(slab) + slab->size;
+            sc.slab = std::min(2 * sc.slab, MAX_SLAB);
+        }
+        auto block = sc.top;
+        sc.top += rounded;
+        return block;
+    }
+
+    /**
+     * put a block on the free list of its size class, or give back its slab if it has one of its own
+     * @param ptr block returned by \a allocate()
+     * @param size \a size passed to \a allocate()
+     */
+    void deallocate(void* ptr, std::size_t size) {
+        const auto rounded = round_up(size);
+        if (rounded > MAX_BLOCK) {
+            delete_slab(reinterpret_cast<Slab*>(static_cast<char*>(ptr) - HEADER));
+            return;
+        }
+        auto& sc = size_class(rounded);
+        *static_cast<void**>(ptr) = sc.free;
+        sc.free = ptr;
+    }
+
+    /**
+     * give all the slabs back to the system at once, invalidating every block allocated so far
+     */
+    void release() {
+        while (_slabs != nullptr) {
+            delete_slab(_slabs);
+        }
+        std::fill(std::begin(_small), std::end(_small), SizeClass());
+        _large.clear();
+    }
+
+private:
+    static std::size_t round_up(std::size_t size) { return (std::max(size, GRANULE) + GRANULE - 1) / GRANULE * GRANULE; }
+
+    /**
+     * @param size minimal slab size, header included; rounded up to whole pages
+     */
+    Slab* new_slab(std::size_t size) {
+        size = (size + Pages::PAGE - 1) / Pages::PAGE * Pages::PAGE;
+        auto slab = static_cast<Slab*>(Pages::allocate(size, HEADER));
+        slab->prev = nullptr;
+        slab->next = _slabs;
+        slab->size = size;
+        if (_slabs != nullptr) {
+            _slabs->prev = slab;
+        }
+        _slabs = slab;
+        return slab;
+    }
+
+    void delete_slab(Slab* slab) {
+        (slab->prev != nullptr ? slab->prev->next : _slabs) = slab->next;
+        if (slab->next != nullptr) {
+            slab->next->prev = slab->prev;
+        }
+        Pages::deallocate(slab, slab->size, HEADER);
+    }
+
+    SizeClass& size_class(std::size_t rounded) {
+        const auto index = rounded / GRANULE - 1;
+        if (index < SMALL_CLASSES) {
+            return _small[index];
+        }
+        for (auto& [size, sc]: _large) {
+            if (size == rounded) {
+                return sc;
+            }
+        }
+        return _large.emplace_back(rounded, SizeClass()).second;
+    }
+};
+
+/**
+ * \a BasicSlabResource taking slabs from the global heap
+ */
+typedef BasicSlabResource<> SlabResource;
+
+/**
+ * allocator drawing from a \a SlabResource shared by all its copies and rebinds, so that the entries and buckets of a
+ * container fill slabs of their own sizes instead of going through the global heap one by one \n
+ * every default-constructed allocator creates a new resource, so the default \a ArbitraryAllocator argument gives
+ * every container its own slabs
+ * @tparam T value type
+ * @tparam Arena if \a true, the allocator provides \a release(), with which containers free all their nodes at once
+ * on \a clear() and destruction instead of one by one (and skip the traversal altogether if the nodes are trivially
+ * destructible); an arena must thus not be shared by two containers (a moved-from container included) holding entries
+ * @tparam Pages where slabs come from (see \a BasicSlabResource)
+ */
+template <typename T, bool Arena = false, typename Pages = HeapPages>
+class SlabAllocator {
+    typedef BasicSlabResource<Pages> Resource;
+
+    static_assert(alignof(T) <= Resource::MAX_ALIGNMENT, "Alignment not supported by slabs");
+
+    template <typename U, bool A, typename P>
+    friend class SlabAllocator;
+
+    std::shared_ptr<Resource> _resource;
+
+public:
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind {
+        typedef SlabAllocator<U, Arena, Pages> other;
+    };
+
+    SlabAllocator(): _resource(std::make_shared<Resource>()) {}
+
+    template <typename U>
+    SlabAllocator(const SlabAllocator<U, Arena, Pages>& other) noexcept: _resource(other._resource) {}
+
+    T* allocate(std::size_t n) {
+        return static_cast<T*>(_resource->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, std::size_t n) {
+        _resource->deallocate(ptr, n * sizeof(T));
+    }
+
+    /**
+     * give all the slabs back to the system at once (arena only), invalidating every block allocated through this
+     * allocator and its copies and rebinds
+     */
+    void release() requires Arena {
+        _resource->release();
+    }
+
+    template <typename U>
+    bool operator==(const SlabAllocator<U, Arena, Pages>& other) const { return _resource == other._resource; }
+};
+
+/**
+ * \a SlabAllocator with \a release()
+ */
+template <typename T>
+using ArenaAllocator = SlabAllocator<T, true>;
+
+/**
+ * \a SlabAllocator backed by (transparent) huge pages, i.e. entries, buckets and level tables of a container fill
+ * 2 MiB pages (see \a yfast::utils::HugePages)
+ */
+template <typename T>
+using HugePageSlabAllocator = SlabAllocator<T, false, HugePages>;
+
+}
+
+#endif
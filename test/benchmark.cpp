@@ -3,87 +3,202 @@
 #include <cstdint>
 #include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
+#if __has_include(<tsl/hopscotch_map.h>)
 #define WITH_HOPSCOTCH 1
+#endif
+#if __has_include(<absl/container/flat_hash_map.h>)
 #define WITH_FLAT_HASH 1
+#endif
+#if __has_include(<ankerl/unordered_dense.h>)
 #define WITH_DENSE_MAP 1
+#endif
+#define WITH_PROBE_COUNT 1
 
-#ifdef WITH_FLAT_HASH
+#if WITH_FLAT_HASH
 #include <absl/container/flat_hash_map.h>
 #endif
-#ifdef WITH_DENSE_MAP
+#if WITH_DENSE_MAP
 #include <ankerl/unordered_dense.h>
 #endif
-#ifdef WITH_HOPSCOTCH
+#if WITH_HOPSCOTCH
 #include <tsl/hopscotch_map.h>
 #endif
 
 #include <yfast/fastmap.h>
 
-int main() {
-    constexpr auto N0 = 10;
-    constexpr auto N1 = 31;
-    constexpr unsigned long int M0 = 1UL << N0;
-    constexpr unsigned long int M1 = 1UL << N1;
-    constexpr auto max_size = std::vector<std::uint32_t>().max_size();
-    static_assert((M1 >> 1) <= max_size, "Unable to allocate even half-sized shuffle");
+constexpr auto N0 = 10;
+constexpr auto N1 = 31;
+constexpr unsigned long int M0 = 1UL << N0;
+constexpr unsigned long int M1 = 1UL << N1;
+constexpr auto N_WIDE = 24;  // sample size for 64- and 128-bit keys
 
-    constexpr auto shuffle_size = std::min(M1, max_size);
-    std::vector<std::uint32_t> shuffle(shuffle_size);
-    for (std::uint32_t i = 0; i < shuffle_size; ++i) {
-        shuffle[i] = i;
+template <typename Hash>
+using FastMap = yfast::fastmap<std::uint32_t, void, N1, yfast::internal::BitExtractor<std::uint32_t>, Hash>;
+
+template <typename Key, typename Hash = yfast::internal::DefaultHash<Key, std::uintptr_t>, typename Buckets = yfast::internal::AVLBuckets, typename Thresholds = yfast::internal::DefaultThresholds, typename Allocator = std::allocator<Key>>
+using WideFastMap = yfast::fastmap<Key, void, 8 * sizeof(Key), yfast::internal::BitExtractor<Key>, Hash, std::less<Key>, Allocator, Buckets, Thresholds>;
+
+#ifdef __SIZEOF_INT128__
+typedef yfast::internal::UInt128 UInt128;
+
+std::ostream& operator << (std::ostream& os, UInt128 key) {
+    return os << std::hex << static_cast<std::uint64_t>(key >> 64) << ":" << static_cast<std::uint64_t>(key) << std::dec;
+}
+#endif
+
+#if WITH_PROBE_COUNT
+/**
+ * level table wrapper counting hash probes; exposes \a find() only if \a WithFind is set
+ */
+template <typename Key, typename Value, bool WithFind>
+class ProbeCounter {
+    std::unordered_map<Key, Value> _map;
+
+public:
+    inline static std::size_t probes = 0;
+
+    Value& operator [] (const Key& key) { ++probes; return _map[key]; }
+    const Value& at(const Key& key) const { ++probes; return _map.at(key); }
+    [[nodiscard]] bool contains(const Key& key) const { ++probes; return _map.contains(key); }
+    [[nodiscard]] std::size_t size() const { return _map.size(); }
+    std::size_t erase(const Key& key) { ++probes; return _map.erase(key); }
+    void clear() { _map.clear(); }
+
+    auto find(const Key& key) requires WithFind { ++probes; return _map.find(key); }
+    auto find(const Key& key) const requires WithFind { ++probes; return _map.find(key); }
+    auto end() const requires WithFind { return _map.end(); }
+    auto erase(typename std::unordered_map<Key, Value>::iterator i) requires WithFind { return _map.erase(i); }
+};
+
+template <bool WithFind>
+void count_probes(const std::vector<std::uint32_t>& shuffle, std::size_t size, std::size_t sample, const char* name) {
+    typedef ProbeCounter<std::uint32_t, std::uintptr_t, WithFind> Hash;
+    FastMap<Hash> fastmap;
+    for (std::size_t i = 0; i < size; ++i) {
+        fastmap.insert(shuffle[i]);
     }
+    Hash::probes = 0;
+    for (std::size_t i = 0; i < sample; ++i) {
+        fastmap.find(shuffle[size - sample + i]);  // hits
+        fastmap.find(shuffle[size + i]);  // misses
+    }
+    std::cout << "M=" << size << " yfast::fastmap+" << name << " probes per find: " << static_cast<double>(Hash::probes) / (2 * sample) << std::endl;
 
-    ::srand(time(nullptr));
-    auto unshuffled = shuffle_size;
-    while (unshuffled > 1) {
-        auto index = ::rand() % unshuffled;
-        std::swap(shuffle[index], shuffle[--unshuffled]);
+    Hash::probes = 0;
+    for (std::size_t i = 0; i < sample; ++i) {
+        fastmap.insert(shuffle[size + i]);
     }
+    std::cout << "M=" << size << " yfast::fastmap+" << name << " probes per insert: " << static_cast<double>(Hash::probes) / sample << std::endl;
 
-    std::chrono::time_point<std::chrono::high_resolution_clock> start, stop;
-    std::chrono::high_resolution_clock::duration duration;
+    Hash::probes = 0;
+    for (std::size_t i = 0; i < sample; ++i) {
+        fastmap.erase(shuffle[size + i]);
+    }
+    std::cout << "M=" << size << " yfast::fastmap+" << name << " probes per erase: " << static_cast<double>(Hash::probes) / sample << std::endl;
+}
+#endif
 
-    std::ofstream stats("benchmark.csv");
-    stats << "implementation,operation,sample,duration" << std::endl;
+template <typename Key>
+void insert(std::map<Key, Key>& map, Key key) {
+    map.insert(std::make_pair(key, key));
+}
 
-    std::map<std::uint32_t, std::uint32_t> map;
+template <typename Map, typename Key>
+void insert(Map& map, Key key) {
+    map.insert(key);
+}
+
+/**
+ * insert, find and find+erase sample keys, doubling and then halving the sample size
+ */
+template <typename Map, typename Key>
+void benchmark(Map& map, const char* name, const std::vector<Key>& shuffle, std::ofstream& stats) {
+    const auto shuffle_size = shuffle.size();
+
+    std::chrono::time_point<std::chrono::high_resolution_clock> start, stop;
+    std::chrono::high_resolution_clock::duration duration;
 
     for (auto i = 0; i < M0; ++i) {
         auto key = shuffle[i];
-        map.insert(std::make_pair(key, key));
+        insert(map, key);
     }
 
-    for (auto M = M0; M < M1; M <<= 1) {
+    for (auto M = M0; M < shuffle_size; M <<= 1) {
         const auto I = std::min(M, shuffle_size - M);
         start = std::chrono::high_resolution_clock::now();
         for (auto i = 0; i < I; ++i) {
             auto key = shuffle[M + i];
-            map.insert(std::make_pair(key, key));
+            insert(map, key);
         }
         stop = std::chrono::high_resolution_clock::now();
         duration = stop - start;
-        std::cout << "M=" << I << " std::map insert: " << duration.count() << std::endl;
-        stats << "std::map,insert," << I << "," << duration.count() << std::endl;
+        std::cout << "M=" << I << " " << name << " insert: " << duration.count() << std::endl;
+        stats << name << ",insert," << I << "," << duration.count() << std::endl;
 
         start = std::chrono::high_resolution_clock::now();
         for (auto i = 0; i < I; ++i) {
             auto key = shuffle[M + i];
             auto pos = map.find(key);
             if (pos == map.end()) {
-                std::cerr << "std::map key=" << key << " not found" << std::endl;
+                std::cerr << name << " key=" << key << " not found" << std::endl;
             }
         }
         stop = std::chrono::high_resolution_clock::now();
         duration = stop - start;
-        std::cout << "M=" << I << " std::map find: " << duration.count() << std::endl;
-        stats << "std::map,find," << I << "," << duration.count() << std::endl;
+        std::cout << "M=" << I << " " << name << " find: " << duration.count() << std::endl;
+        stats << name << ",find," << I << "," << duration.count() << std::endl;
+
+        if constexpr (requires (std::span<typename Map::iterator> found) { map.find_batch(std::span(shuffle), found); }) {
+            std::vector<typename Map::iterator> found(I);
+            start = std::chrono::high_resolution_clock::now();
+            map.find_batch(std::span(shuffle).subspan(M, I), found);
+            stop = std::chrono::high_resolution_clock::now();
+            duration = stop - start;
+            std::cout << "M=" << I << " " << name << " find_batch: " << duration.count() << std::endl;
+            stats << name << ",find_batch," << I << "," << duration.count() << std::endl;
+        }
+
+        if constexpr (requires { map.make_cursor(); }) {
+            std::vector<Key> sorted(shuffle.begin() + M, shuffle.begin() + M + I);
+            std::ranges::sort(sorted);
+            auto cursor = map.make_cursor();
+            start = std::chrono::high_resolution_clock::now();
+            for (auto key: sorted) {
+                auto pos = cursor.find(key);
+                if (pos == map.end()) {
+                    std::cerr << name << " key=" << key << " not found" << std::endl;
+                }
+            }
+            stop = std::chrono::high_resolution_clock::now();
+            duration = stop - start;
+            std::cout << "M=" << I << " " << name << " find_sorted_cursor: " << duration.count() << std::endl;
+            stats << name << ",find_sorted_cursor," << I << "," << duration.count() << std::endl;
+
+            start = std::chrono::high_resolution_clock::now();
+            for (auto key: sorted) {
+                auto pos = map.find(key);
+                if (pos == map.end()) {
+                    std::cerr << name << " key=" << key << " not found" << std::endl;
+                }
+            }
+            stop = std::chrono::high_resolution_clock::now();
+            duration = stop - start;
+            std::cout << "M=" << I << " " << name << " find_sorted: " << duration.count() << std::endl;
+            stats << name << ",find_sorted," << I << "," << duration.count() << std::endl;
+        }
     }
 
-    for (auto M = M1 >> 1; M >= M0; M >>= 1) {
+    for (auto M = shuffle_size >> 1; M >= M0; M >>= 1) {
         const auto I = std::min(M, shuffle_size - M);
         start = std::chrono::high_resolution_clock::now();
         for (auto i = 0; i < I; ++i) {
@@ -93,212 +208,255 @@ int main() {
         }
         stop = std::chrono::high_resolution_clock::now();
         duration = stop - start;
-        std::cout << "M=" << I << " std::map find+erase: " << duration.count() << std::endl;
-        stats << "std::map,find+erase," << I << "," << duration.count() << std::endl;
+        std::cout << "M=" << I << " " << name << " find+erase: " << duration.count() << std::endl;
+        stats << name << ",find+erase," << I << "," << duration.count() << std::endl;
     }
 
     map.clear();
+}
 
-    yfast::fastmap<std::uint32_t, void, N1, yfast::internal::BitExtractor<std::uint32_t>, std::unordered_map<std::uint32_t, std::uintptr_t>> fastmap;
+/**
+ * fill the map with the whole sample and clear it
+ */
+template <typename Map, typename Key>
+void teardown(Map& map, const char* name, const std::vector<Key>& shuffle, std::ofstream& stats) {
+    for (auto key: shuffle) {
+        map.insert(key);
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    map.clear();
+    auto stop = std::chrono::high_resolution_clock::now();
+    auto duration = stop - start;
+    std::cout << "M=" << shuffle.size() << " " << name << " clear: " << duration.count() << std::endl;
+    stats << name << ",clear," << shuffle.size() << "," << duration.count() << std::endl;
+}
 
-    for (auto i = 0; i < M0; ++i) {
-        auto key = shuffle[i];
-        fastmap.insert(key);
+/**
+ * fill the map with the first half of the sample, then insert the second half, erasing the first one and looking up
+ * \a reads keys on the way for every key inserted
+ * @return workload duration
+ */
+template <typename Map, typename Key>
+std::chrono::high_resolution_clock::duration mixed_workload(Map& map, const std::vector<Key>& shuffle, unsigned int reads) {
+    const auto half = shuffle.size() / 2;
+    for (std::size_t i = 0; i < half; ++i) {
+        map.insert(shuffle[i]);
     }
+    auto start = std::chrono::high_resolution_clock::now();
+    for (std::size_t i = 0; i < half; ++i) {
+        map.insert(shuffle[half + i]);
+        for (unsigned int j = 1; j <= reads; ++j) {
+            map.find(shuffle[(i * reads + j) % (half + i + 1)]);
+        }
+        map.erase(shuffle[i]);
+    }
+    auto stop = std::chrono::high_resolution_clock::now();
+    map.clear();
+    return stop - start;
+}
 
-    for (auto M = M0; M < M1; M <<= 1) {
-        const auto I = std::min(M, shuffle_size - M);
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
+/**
+ * time the mixed workload for every split threshold in \a Splits (merging below one eighth of it) as well as for
+ * adaptive thresholds and report the fastest setting
+ */
+template <unsigned int... Splits, typename Key>
+void sweep_thresholds(const std::vector<Key>& shuffle, unsigned int reads, std::ofstream& stats) {
+    std::string best;
+    auto best_duration = std::chrono::high_resolution_clock::duration::max();
+    auto run = [&] <typename Thresholds> (const std::string& name) {
+        WideFastMap<Key, yfast::internal::DefaultHash<Key, std::uintptr_t>, yfast::internal::AVLBuckets, Thresholds> fastmap;
+        auto duration = mixed_workload(fastmap, shuffle, reads);
+        std::cout << "reads=" << reads << " yfast::fastmap+" << name << " mixed: " << duration.count() << std::endl;
+        stats << "yfast::fastmap+" << name << ",mixed" << reads << "," << shuffle.size() / 2 << "," << duration.count() << std::endl;
+        if (duration < best_duration) {
+            best_duration = duration;
+            best = name;
+        }
+    };
+    (run.template operator () <yfast::internal::FixedThresholds<Splits, Splits / 8>>("split=" + std::to_string(Splits)), ...);
+    run.template operator () <yfast::internal::AdaptiveThresholds<>>("adaptive");
+    std::cout << "reads=" << reads << " best thresholds: " << best << std::endl;
+}
+
+/**
+ * time inserting and then finding every key of the sample (in shuffled order) with the nodes and level tables on
+ * slabs of normal and of huge pages
+ */
+template <typename Key>
+void compare_pages(const std::vector<Key>& shuffle, std::ofstream& stats) {
+    auto run = [&] <typename Allocator> (const std::string& name) {
+        WideFastMap<Key, yfast::internal::DefaultHash<Key, std::uintptr_t>, yfast::internal::AVLBuckets, yfast::internal::DefaultThresholds, Allocator> fastmap;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (auto key: shuffle) {
             fastmap.insert(key);
         }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+std::unordered_map insert: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+std::unordered_map,insert," << I << "," << duration.count() << std::endl;
+        auto stop = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double, std::nano> duration = stop - start;
+        std::cout << "M=" << shuffle.size() << " " << name << " insert: " << duration.count() / shuffle.size() << " ns/key" << std::endl;
+        stats << name << ",insert," << shuffle.size() << "," << duration.count() << std::endl;
 
         start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            auto pos = fastmap.find(key);
-            if (pos == fastmap.end()) {
-                std::cerr << "yfast::fastmap+std::unordered_map key=" << key << " not found" << std::endl;
+        for (auto key: shuffle) {
+            if (fastmap.find(key) == fastmap.end()) {
+                std::cerr << name << " key=" << key << " not found" << std::endl;
             }
         }
         stop = std::chrono::high_resolution_clock::now();
         duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+std::unordered_map find: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+std::unordered_map,find," << I << "," << duration.count() << std::endl;
-    }
+        std::cout << "M=" << shuffle.size() << " " << name << " find: " << duration.count() / shuffle.size() << " ns/key" << std::endl;
+        stats << name << ",find," << shuffle.size() << "," << duration.count() << std::endl;
+    };
+    run.template operator () <yfast::utils::SlabAllocator<Key>>("yfast::fastmap<uint64>+yfast::utils::SlabAllocator");
+    run.template operator () <yfast::utils::HugePageSlabAllocator<Key>>("yfast::fastmap<uint64>+yfast::utils::HugePageSlabAllocator");
+}
 
-    for (auto M = M1 >> 1; M >= M0; M >>= 1) {
-        const auto I = std::min(M, shuffle_size - M);
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            auto pos = fastmap.find(key);
-            fastmap.erase(pos);
+int main(int argc, char* argv[]) {
+    // "benchmark sweep [reads per update]" only looks for the best bucket thresholds for a mixed workload
+    if (argc > 1 && std::string_view(argv[1]) == "sweep") {
+        const unsigned int reads = argc > 2 ? std::atoi(argv[2]) : 4;
+        std::vector<std::uint64_t> sample(1UL << N_WIDE);
+        for (std::size_t i = 0; i < sample.size(); ++i) {
+            sample[i] = i * 0x9e3779b97f4a7c15ULL;  // a permutation of the key space spreading the keys apart
         }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+std::unordered_map find+erase: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+std::unordered_map,find+erase," << I << "," << duration.count() << std::endl;
+        std::ofstream stats("sweep.csv");
+        stats << "implementation,operation,sample,duration" << std::endl;
+        sweep_thresholds<16, 32, 64, 128, 256, 512>(sample, reads, stats);
+        return EXIT_SUCCESS;
+    }
+    // "benchmark hugepages [log2 of sample size]" only compares nodes and level tables on normal and on huge pages
+    if (argc > 1 && std::string_view(argv[1]) == "hugepages") {
+        const unsigned int bits = argc > 2 ? std::atoi(argv[2]) : N_WIDE;
+        std::vector<std::uint64_t> sample(1UL << bits);
+        for (std::size_t i = 0; i < sample.size(); ++i) {
+            sample[i] = i * 0x9e3779b97f4a7c15ULL;
+        }
+        std::ofstream stats("hugepages.csv");
+        stats << "implementation,operation,sample,duration" << std::endl;
+        compare_pages(sample, stats);
+        return EXIT_SUCCESS;
     }
 
-    fastmap.clear();
+    constexpr auto max_size = std::vector<std::uint32_t>().max_size();
+    static_assert((M1 >> 1) <= max_size, "Unable to allocate even half-sized shuffle");
 
-#if WITH_HOPSCOTCH
-    yfast::fastmap<std::uint32_t, void, N1, yfast::internal::BitExtractor<std::uint32_t>, tsl::hopscotch_map<std::uint32_t, std::uintptr_t>> fastmap_hopscotch;
+    constexpr auto shuffle_size = std::min(M1, max_size);
+    std::vector<std::uint32_t> shuffle(shuffle_size);
+    for (std::uint32_t i = 0; i < shuffle_size; ++i) {
+        shuffle[i] = i;
+    }
 
-    for (auto i = 0; i < M0; ++i) {
-        auto key = shuffle[i];
-        fastmap_hopscotch.insert(key);
+    ::srand(time(nullptr));
+    auto unshuffled = shuffle_size;
+    while (unshuffled > 1) {
+        auto index = ::rand() % unshuffled;
+        std::swap(shuffle[index], shuffle[--unshuffled]);
     }
 
-    for (auto M = M0; M < M1; M <<= 1) {
-        const auto I = std::min(M, shuffle_size - M);
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            fastmap_hopscotch.insert(key);
-        }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+tsl::hopscotch insert: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+tsl::hopscotch,insert," << I << "," << duration.count() << std::endl;
+    std::ofstream stats("benchmark.csv");
+    stats << "implementation,operation,sample,duration" << std::endl;
 
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            auto pos = fastmap_hopscotch.find(key);
-            if (pos == fastmap_hopscotch.end()) {
-                std::cerr << "yfast::fastmap+tsl::hopscotch key=" << key << " not found" << std::endl;
-            }
-        }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+tsl::hopscotch find: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+tsl::hopscotch,find," << I << "," << duration.count() << std::endl;
-    }
+    std::map<std::uint32_t, std::uint32_t> map;
+    benchmark(map, "std::map", shuffle, stats);
 
-    for (auto M = M1 >> 1; M >= M0; M >>= 1) {
-        const auto I = std::min(M, shuffle_size - M);
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            auto pos = fastmap_hopscotch.find(key);
-            fastmap_hopscotch.erase(pos);
-        }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+tsl::hopscotch find+erase: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+tsl::hopscotch,find+erase," << I << "," << duration.count() << std::endl;
-    }
+    FastMap<std::unordered_map<std::uint32_t, std::uintptr_t>> fastmap;
+    benchmark(fastmap, "yfast::fastmap+std::unordered_map", shuffle, stats);
+
+    FastMap<yfast::internal::FlatMap<std::uint32_t, std::uintptr_t>> fastmap_flat_map;
+    benchmark(fastmap_flat_map, "yfast::fastmap+yfast::internal::FlatMap", shuffle, stats);
+
+    FastMap<yfast::internal::UnifiedLevels<>> fastmap_unified;
+    benchmark(fastmap_unified, "yfast::fastmap+yfast::internal::UnifiedLevels", shuffle, stats);
 
-    fastmap_hopscotch.clear();
+    FastMap<yfast::internal::DirectTopLevels<>> fastmap_direct_top;
+    benchmark(fastmap_direct_top, "yfast::fastmap+yfast::internal::DirectTopLevels", shuffle, stats);
+
+#if WITH_HOPSCOTCH
+    FastMap<tsl::hopscotch_map<std::uint32_t, std::uintptr_t>> fastmap_hopscotch;
+    benchmark(fastmap_hopscotch, "yfast::fastmap+tsl::hopscotch", shuffle, stats);
 #endif
 
 #if WITH_FLAT_HASH
-    yfast::fastmap<std::uint32_t, void, N1, yfast::internal::BitExtractor<std::uint32_t>, absl::flat_hash_map<std::uint32_t, std::uintptr_t>> fastmap_flat_hash;
+    FastMap<absl::flat_hash_map<std::uint32_t, std::uintptr_t>> fastmap_flat_hash;
+    benchmark(fastmap_flat_hash, "yfast::fastmap+absl::flat_hash_map", shuffle, stats);
+#endif
 
-    for (auto i = 0; i < M0; ++i) {
-        auto key = shuffle[i];
-        fastmap_flat_hash.insert(key);
+#if WITH_DENSE_MAP
+    FastMap<ankerl::unordered_dense::map<std::uint32_t, std::uintptr_t>> fastmap_dense_map;
+    benchmark(fastmap_dense_map, "yfast::fastmap+ankerl::unordered_dense::map", shuffle, stats);
+#endif
+
+    // signed and floating point keys on the same sample as the wide keys, next to unsigned ones of the same width
+    std::vector<std::uint32_t> shuffle32(shuffle.begin(), shuffle.begin() + std::min(1UL << N_WIDE, shuffle_size));
+    std::vector<std::int32_t> shuffle_signed(shuffle32.size());
+    std::vector<double> shuffle_double(shuffle32.size());
+    for (std::size_t i = 0; i < shuffle32.size(); ++i) {
+        shuffle_signed[i] = static_cast<std::int32_t>(shuffle32[i]) - (1 << (N1 - 1));
+        shuffle_double[i] = static_cast<double>(shuffle_signed[i]) / 1024;
     }
 
-    for (auto M = M0; M < M1; M <<= 1) {
-        const auto I = std::min(M, shuffle_size - M);
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            fastmap_flat_hash.insert(key);
-        }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+absl::flat_hash_map insert: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+absl::flat_hash_map,insert," << I << "," << duration.count() << std::endl;
+    WideFastMap<std::uint32_t> fastmap32;
+    benchmark(fastmap32, "yfast::fastmap<uint32>", shuffle32, stats);
 
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            auto pos = fastmap_flat_hash.find(key);
-            if (pos == fastmap_flat_hash.end()) {
-                std::cerr << "yfast::fastmap+absl::flat_hash_map key=" << key << " not found" << std::endl;
-            }
-        }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+absl::flat_hash_map find: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+absl::flat_hash_map,find," << I << "," << duration.count() << std::endl;
-    }
+    WideFastMap<std::int32_t> fastmap_signed;
+    benchmark(fastmap_signed, "yfast::fastmap<int32>", shuffle_signed, stats);
 
-    for (auto M = M1 >> 1; M >= M0; M >>= 1) {
-        const auto I = std::min(M, shuffle_size - M);
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            auto pos = fastmap_flat_hash.find(key);
-            fastmap_flat_hash.erase(pos);
-        }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+absl::flat_hash_map find+erase: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+absl::flat_hash_map,find+erase," << I << "," << duration.count() << std::endl;
+    WideFastMap<double> fastmap_double;
+    benchmark(fastmap_double, "yfast::fastmap<double>", shuffle_double, stats);
+
+    // odd multipliers permute the key space, so the shuffled keys stay distinct while spreading over all the bits
+    std::vector<std::uint64_t> shuffle64(shuffle.begin(), shuffle.begin() + std::min(1UL << N_WIDE, shuffle_size));
+    for (auto& key: shuffle64) {
+        key *= 0x9e3779b97f4a7c15ULL;
     }
 
-    fastmap_flat_hash.clear();
-#endif
+    std::map<std::uint64_t, std::uint64_t> map64;
+    benchmark(map64, "std::map<uint64>", shuffle64, stats);
 
-#if WITH_DENSE_MAP
-    yfast::fastmap<std::uint32_t, void, N1, yfast::internal::BitExtractor<std::uint32_t>, ankerl::unordered_dense::map<std::uint32_t, std::uintptr_t>> fastmap_dense_map;
+    WideFastMap<std::uint64_t> fastmap64;
+    benchmark(fastmap64, "yfast::fastmap<uint64>", shuffle64, stats);
 
-    for (auto i = 0; i < M0; ++i) {
-        auto key = shuffle[i];
-        fastmap_dense_map.insert(key);
-    }
+    WideFastMap<std::uint64_t, yfast::internal::UnifiedLevels<>> fastmap64_unified;
+    benchmark(fastmap64_unified, "yfast::fastmap<uint64>+yfast::internal::UnifiedLevels", shuffle64, stats);
 
-    for (auto M = M0; M < M1; M <<= 1) {
-        const auto I = std::min(M, shuffle_size - M);
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            fastmap_dense_map.insert(key);
-        }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+ankerl::unordered_dense::map insert: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+ankerl::unordered_dense::map,insert," << I << "," << duration.count() << std::endl;
+    WideFastMap<std::uint64_t, yfast::internal::DirectTopLevels<>> fastmap64_direct_top;
+    benchmark(fastmap64_direct_top, "yfast::fastmap<uint64>+yfast::internal::DirectTopLevels", shuffle64, stats);
 
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            auto pos = fastmap_dense_map.find(key);
-            if (pos == fastmap_dense_map.end()) {
-                std::cerr << "yfast::fastmap+ankerl::unordered_dense::map key=" << key << " not found" << std::endl;
-            }
-        }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+ankerl::unordered_dense::map find: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+ankerl::unordered_dense::map,find," << I << "," << duration.count() << std::endl;
-    }
+    WideFastMap<std::uint64_t, yfast::internal::DefaultHash<std::uint64_t, std::uintptr_t>, yfast::internal::SortedArrayBuckets> fastmap64_sorted_array;
+    benchmark(fastmap64_sorted_array, "yfast::fastmap<uint64>+yfast::internal::SortedArrayBuckets", shuffle64, stats);
 
-    for (auto M = M1 >> 1; M >= M0; M >>= 1) {
-        const auto I = std::min(M, shuffle_size - M);
-        start = std::chrono::high_resolution_clock::now();
-        for (auto i = 0; i < I; ++i) {
-            auto key = shuffle[M + i];
-            auto pos = fastmap_dense_map.find(key);
-            fastmap_dense_map.erase(pos);
-        }
-        stop = std::chrono::high_resolution_clock::now();
-        duration = stop - start;
-        std::cout << "M=" << I << " yfast::fastmap+ankerl::unordered_dense::map find+erase: " << duration.count() << std::endl;
-        stats << "yfast::fastmap+ankerl::unordered_dense::map,find+erase," << I << "," << duration.count() << std::endl;
+    WideFastMap<std::uint64_t, yfast::internal::DefaultHash<std::uint64_t, std::uintptr_t>, yfast::internal::CompactAVLBuckets<>> fastmap64_compact;
+    benchmark(fastmap64_compact, "yfast::fastmap<uint64>+yfast::internal::CompactAVLBuckets", shuffle64, stats);
+
+    typedef yfast::internal::DefaultHash<std::uint64_t, std::uintptr_t> Hash64;
+    WideFastMap<std::uint64_t, Hash64, yfast::internal::AVLBuckets, yfast::internal::DefaultThresholds, yfast::utils::SlabAllocator<std::uint64_t>> fastmap64_slab;
+    benchmark(fastmap64_slab, "yfast::fastmap<uint64>+yfast::utils::SlabAllocator", shuffle64, stats);
+
+    teardown(fastmap64, "yfast::fastmap<uint64>", shuffle64, stats);
+    teardown(fastmap64_slab, "yfast::fastmap<uint64>+yfast::utils::SlabAllocator", shuffle64, stats);
+    WideFastMap<std::uint64_t, Hash64, yfast::internal::AVLBuckets, yfast::internal::DefaultThresholds, yfast::utils::ArenaAllocator<std::uint64_t>> fastmap64_arena;
+    teardown(fastmap64_arena, "yfast::fastmap<uint64>+yfast::utils::ArenaAllocator", shuffle64, stats);
+
+#ifdef __SIZEOF_INT128__
+    std::vector<UInt128> shuffle128(shuffle64.begin(), shuffle64.end());
+    for (auto& key: shuffle128) {
+        key *= (static_cast<UInt128>(0xda942042e4dd58b5ULL) << 64) | 0x9e3779b97f4a7c15ULL;
     }
 
-    fastmap_dense_map.clear();
+    std::map<UInt128, UInt128> map128;
+    benchmark(map128, "std::map<uint128>", shuffle128, stats);
+
+    WideFastMap<UInt128> fastmap128;
+    benchmark(fastmap128, "yfast::fastmap<uint128>", shuffle128, stats);
+
+    WideFastMap<UInt128, yfast::internal::UnifiedLevels<>> fastmap128_unified;
+    benchmark(fastmap128_unified, "yfast::fastmap<uint128>+yfast::internal::UnifiedLevels", shuffle128, stats);
+#endif
+
+#if WITH_PROBE_COUNT
+    constexpr std::size_t probe_size = std::min(1UL << 20, shuffle_size >> 1);
+    constexpr std::size_t probe_sample = std::min(1UL << 16, probe_size);
+    count_probes<false>(shuffle, probe_size, probe_sample, "contains/at/erase(key)");
+    count_probes<true>(shuffle, probe_size, probe_sample, "find/erase(iterator)");
 #endif
 
     stats.close();
@@ -1,6 +1,18 @@
+#include <algorithm>
+#include <array>
 #include <cstdint>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <map>
+#include <memory>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
 
 #include <yfast/fastmap.h>
 #include <yfast/iterator.h>
@@ -291,3 +303,707 @@ TEST(fastmap, make_reverse) {
     EXPECT_EQ(yfast::make_reverse_iterator(fastmap.cbegin()), fastmap.crend());
     EXPECT_EQ(yfast::make_reverse_iterator(fastmap.cend()), fastmap.crbegin());
 }
+
+/**
+ * fastmap of 32-bit keys to \a Value with the given bucket, allocator and thresholds policies
+ */
+template <typename Value, typename Buckets = yfast::internal::AVLBuckets, typename Allocator = std::allocator<std::uint32_t>, typename Thresholds = yfast::internal::DefaultThresholds>
+using Fastmap32 = yfast::fastmap<std::uint32_t, Value, 32, yfast::internal::BitExtractor<std::uint32_t>, yfast::internal::DefaultHash<std::uint32_t, std::uintptr_t>, std::less<>, Allocator, Buckets, Thresholds>;
+
+/**
+ * @return value of the \a i th update, strings being too long to be stored inline
+ */
+template <typename Value>
+Value make_value(int i) {
+    if constexpr (std::is_same_v<Value, std::string>) {
+        return std::string(32, static_cast<char>('a' + i % 26));
+    }
+    else {
+        return static_cast<Value>(i);
+    }
+}
+
+/**
+ * checks that \a fastmap holds the same entries as \a map, in the same order
+ */
+template <typename Fastmap, typename Value>
+void expect_same(const Fastmap& fastmap, const std::map<std::uint32_t, Value>& map) {
+    ASSERT_EQ(fastmap.size(), map.size());
+    auto i = fastmap.begin();
+    for (const auto& [k, v]: map) {
+        EXPECT_EQ(i.key(), k);
+        EXPECT_EQ(*i, v);
+        ++i;
+    }
+    EXPECT_EQ(i, fastmap.end());
+}
+
+/**
+ * applies \a updates pseudo-random updates of keys below \a range to both \a fastmap and \a map, every third one
+ * erasing a key, and checks that they end up with the same entries
+ */
+template <typename Fastmap, typename Value>
+void churn(Fastmap& fastmap, std::map<std::uint32_t, Value>& map, int updates = 5000, std::uint32_t seed = 1, std::uint32_t range = 20000) {
+    std::uint32_t key = seed;
+    for (auto i = 0; i < updates; ++i) {
+        key = key * 1664525 + 1013904223;
+        const auto k = key % range;
+        if (i % 3 == 2) {
+            EXPECT_EQ(fastmap.erase(k), map.erase(k) > 0);
+        }
+        else {
+            fastmap[k] = make_value<Value>(i);
+            map[k] = make_value<Value>(i);
+        }
+    }
+    expect_same(fastmap, map);
+}
+
+TEST(fastmap, unified_levels) {
+    yfast::fastmap<std::uint32_t, std::uint32_t, 32, yfast::internal::BitExtractor<std::uint32_t>, yfast::internal::UnifiedLevels<>> fastmap;
+    std::map<std::uint32_t, std::uint32_t> map;
+    fastmap.reserve(1000);
+    churn(fastmap, map, 1500, 1, std::numeric_limits<std::uint32_t>::max());
+    for (auto i = fastmap.begin(); i != fastmap.end(); ++i) {
+        EXPECT_EQ(fastmap.pred(i.key() + 1), i);
+    }
+}
+
+TEST(fastmap, unified_levels_string) {
+    yfast::fastmap<std::string, int, 64, yfast::internal::BitExtractor<std::string>, yfast::internal::UnifiedLevels<>> fastmap;
+    for (auto i = 0; i < 100; ++i) {
+        fastmap["key" + std::to_string(1000 + i)] = i;
+    }
+    EXPECT_EQ(fastmap.size(), 100);
+    EXPECT_EQ(fastmap.at("key1042"), 42);
+    EXPECT_EQ(*fastmap.succ("key1042", true), 43);
+}
+
+TEST(fastmap, direct_top_levels) {
+    yfast::fastmap<std::uint32_t, std::uint32_t, 32, yfast::internal::BitExtractor<std::uint32_t>, yfast::internal::DirectTopLevels<>> fastmap;
+    std::map<std::uint32_t, std::uint32_t> map;
+    churn(fastmap, map, 1500, 1, std::numeric_limits<std::uint32_t>::max());
+    for (const auto& [k, v]: map) {
+        EXPECT_EQ(*fastmap.find(k), v);
+        EXPECT_EQ(fastmap.pred(k + 1).key(), k);
+        EXPECT_EQ(fastmap.succ(k - 1).key(), k);
+    }
+}
+
+TEST(fastmap, batch) {
+    yfast::fastmap<std::uint32_t, std::uint32_t, 32> fastmap;
+    std::map<std::uint32_t, std::uint32_t> map;
+    churn(fastmap, map, 1500, 1, std::numeric_limits<std::uint32_t>::max());
+    std::vector<std::uint32_t> keys;
+    for (const auto& entry: map) {
+        keys.push_back(entry.first);
+        keys.push_back(entry.first + 1);
+    }
+    std::vector<decltype(fastmap)::iterator> found(keys.size());
+    fastmap.find_batch(keys, found);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(found[i], fastmap.find(keys[i]));
+    }
+    fastmap.pred_batch(keys, found, true);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(found[i], fastmap.pred(keys[i], true));
+    }
+    fastmap.succ_batch(keys, found);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(found[i], fastmap.succ(keys[i]));
+    }
+
+    const auto& const_fastmap = fastmap;
+    std::vector<decltype(fastmap)::const_iterator> const_found(keys.size());
+    const_fastmap.succ_batch(keys, const_found, true);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(const_found[i], const_fastmap.succ(keys[i], true));
+    }
+}
+
+TEST(fastmap, sorted_array_buckets) {
+    Fastmap32<int, yfast::internal::SortedArrayBuckets> fastmap;
+    std::map<std::uint32_t, int> map;
+    churn(fastmap, map);
+    auto r = fastmap.rbegin();
+    for (auto j = map.rbegin(); j != map.rend(); ++j, ++r) {
+        EXPECT_EQ(r.key(), j->first);
+    }
+    for (std::uint32_t k = 0; k < 20000; k += 7) {
+        EXPECT_EQ(fastmap.find(k) != fastmap.end(), map.contains(k));
+        auto succ = map.upper_bound(k);
+        if (succ != map.end()) {
+            EXPECT_EQ(fastmap.upper_bound(k).key(), succ->first);
+        }
+    }
+    // erasing by iterator walks across splits and merges
+    for (auto j = fastmap.begin(); j != fastmap.end(); ) {
+        if (j.key() % 2 == 0) {
+            map.erase(j.key());
+            j = fastmap.erase(j);
+        }
+        else {
+            ++j;
+        }
+    }
+    expect_same(fastmap, map);
+    fastmap.clear();
+    EXPECT_EQ(fastmap.size(), 0);
+    EXPECT_EQ(fastmap.begin(), fastmap.end());
+}
+
+template <typename Buckets>
+void check_min_representatives() {
+    Fastmap32<int, Buckets> fastmap;
+    std::map<std::uint32_t, int> map;
+    churn(fastmap, map);
+    // a new global minimum rekeys the leftmost bucket, and so does erasing it
+    for (auto i = 0; i < 4; ++i) {
+        fastmap[0] = i;
+        map[0] = i;
+        EXPECT_EQ(fastmap.begin().key(), 0);
+        fastmap.erase(0);
+        map.erase(0);
+        EXPECT_EQ(fastmap.begin().key(), map.begin()->first);
+    }
+
+    std::vector<std::uint32_t> keys;
+    for (std::uint32_t k = 0; k < 20010; k += 3) {
+        keys.push_back(k);
+    }
+    std::vector<typename decltype(fastmap)::iterator> found(keys.size());
+    auto cursor = fastmap.make_cursor();
+    for (auto strict: {false, true}) {
+        fastmap.pred_batch(keys, found, strict);
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            const auto k = keys[i];
+            auto pred = strict ? map.lower_bound(k) : map.upper_bound(k);
+            if (pred == map.begin()) {
+                EXPECT_EQ(fastmap.pred(k, strict), fastmap.end());
+            }
+            else {
+                EXPECT_EQ(fastmap.pred(k, strict).key(), std::prev(pred)->first);
+            }
+            EXPECT_EQ(found[i], fastmap.pred(k, strict));
+            EXPECT_EQ(cursor.pred(k, strict), fastmap.pred(k, strict));
+        }
+        fastmap.succ_batch(keys, found, strict);
+        for (std::size_t i = 0; i < keys.size(); ++i) {
+            const auto k = keys[i];
+            auto succ = strict ? map.upper_bound(k) : map.lower_bound(k);
+            if (succ == map.end()) {
+                EXPECT_EQ(fastmap.succ(k, strict), fastmap.end());
+            }
+            else {
+                EXPECT_EQ(fastmap.succ(k, strict).key(), succ->first);
+            }
+            EXPECT_EQ(found[i], fastmap.succ(k, strict));
+            EXPECT_EQ(cursor.succ(k, strict), fastmap.succ(k, strict));
+        }
+    }
+    fastmap.find_batch(keys, found);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        EXPECT_EQ(fastmap.find(keys[i]) != fastmap.end(), map.contains(keys[i]));
+        EXPECT_EQ(found[i], fastmap.find(keys[i]));
+        EXPECT_EQ(cursor.find(keys[i]), fastmap.find(keys[i]));
+    }
+
+    // erasing the minimum over and over again rekeys the leftmost bucket every time
+    while (!map.empty()) {
+        EXPECT_EQ(fastmap.begin().key(), map.begin()->first);
+        fastmap.erase(fastmap.begin());
+        map.erase(map.begin());
+    }
+    EXPECT_EQ(fastmap.size(), 0);
+}
+
+TEST(fastmap, min_representatives) {
+    check_min_representatives<yfast::internal::MinimumRepresentatives<>>();
+    check_min_representatives<yfast::internal::MinimumRepresentatives<yfast::internal::SortedArrayBuckets>>();
+    check_min_representatives<yfast::internal::MinimumRepresentatives<yfast::internal::CompactAVLBuckets<>>>();
+}
+
+template <typename Buckets>
+void check_compact_buckets() {
+    Fastmap32<int, Buckets> fastmap;
+    std::map<std::uint32_t, int> map;
+    churn(fastmap, map);
+    fastmap.clear();
+    EXPECT_EQ(fastmap.begin(), fastmap.end());
+}
+
+TEST(fastmap, compact_buckets) {
+    EXPECT_EQ(sizeof(yfast::internal::YFastLeaf<std::uint32_t, void, yfast::internal::CompactLayout<>>), 16);
+    check_compact_buckets<yfast::internal::CompactAVLBuckets<>>();
+    check_compact_buckets<yfast::internal::CompactAVLBuckets<true>>();
+}
+
+template <typename Buckets>
+void check_assign_sorted() {
+    Fastmap32<int, Buckets> fastmap;
+    fastmap[7] = 7;
+    std::map<std::uint32_t, int> map;
+    std::vector<std::pair<std::uint32_t, int>> sorted;
+    for (std::uint32_t k = 0; k < 20000; k += 1 + k % 5) {
+        sorted.emplace_back(k, -1);
+        sorted.emplace_back(k, static_cast<int>(k));  // the last of equal keys wins
+        map[k] = static_cast<int>(k);
+    }
+    fastmap.assign_sorted(sorted.begin(), sorted.end());
+    expect_same(fastmap, map);
+    for (std::uint32_t k = 0; k < 20010; k += 3) {
+        EXPECT_EQ(fastmap.find(k) != fastmap.end(), map.contains(k));
+        auto succ = map.lower_bound(k);
+        if (succ != map.end()) {
+            EXPECT_EQ(fastmap.succ(k).key(), succ->first);
+        }
+        auto pred = map.upper_bound(k);
+        if (pred != map.begin()) {
+            EXPECT_EQ(fastmap.pred(k).key(), std::prev(pred)->first);
+        }
+    }
+    // buckets split and merge as usual afterwards
+    churn(fastmap, map, 10000);
+
+    std::swap(sorted.front(), sorted.back());
+    EXPECT_THROW(fastmap.assign_sorted(sorted.begin(), sorted.end()), std::invalid_argument);
+    EXPECT_EQ(fastmap.size(), 0);
+    fastmap.assign_sorted(sorted.end(), sorted.end());
+    EXPECT_EQ(fastmap.begin(), fastmap.end());
+}
+
+TEST(fastmap, assign_sorted) {
+    check_assign_sorted<yfast::internal::AVLBuckets>();
+    check_assign_sorted<yfast::internal::SortedArrayBuckets>();
+    check_assign_sorted<yfast::internal::CompactAVLBuckets<true>>();
+    check_assign_sorted<yfast::internal::MinimumRepresentatives<>>();
+
+    yfast::fastmap<std::uint64_t, void, 64> fastmap;
+    std::vector<std::uint64_t> keys { 1, 2, 3, 5, 8, 13, 21, 34, 55, 89 };
+    fastmap.assign_sorted(keys.begin(), keys.end());
+    EXPECT_TRUE(std::equal(keys.begin(), keys.end(), fastmap.begin(), fastmap.end()));
+    EXPECT_EQ(fastmap.pred(20).key(), 13);
+
+    // single-pass ranges are cut into buckets as they go as well
+    std::istringstream stream("1 2 2 3 5 8 13 21 34 55 89 144 233 377 610 987 1597 2584 4181 6765");
+    fastmap.assign_sorted(std::istream_iterator<std::uint64_t>(stream), std::istream_iterator<std::uint64_t>());
+    EXPECT_EQ(fastmap.size(), 19);
+    EXPECT_EQ(fastmap.pred(1000).key(), 987);
+
+    // a failure halfway through leaves the container empty
+    Fastmap32<int> failing;
+    auto entries = std::views::iota(0, 5000) | std::views::transform([] (int k) {
+        if (k == 3000) {
+            throw std::runtime_error("entry");
+        }
+        return std::pair<std::uint32_t, int>(k, k);
+    });
+    EXPECT_THROW(failing.assign_sorted(entries.begin(), entries.end()), std::runtime_error);
+    EXPECT_TRUE(failing.empty());
+    EXPECT_EQ(failing.begin(), failing.end());
+    failing[1] = 1;
+    EXPECT_EQ(failing.size(), 1);
+}
+
+template <typename Value, typename Allocator, typename Buckets = yfast::internal::AVLBuckets>
+void check_slab_allocator() {
+    typedef Fastmap32<Value, Buckets, Allocator> Fastmap;
+    Fastmap fastmap;
+    std::map<std::uint32_t, Value> map;
+    for (std::uint32_t round = 0; round < 2; ++round) {
+        // the second round fills slabs (or an arena) given back to the allocator
+        churn(fastmap, map, 5000, round + 1);
+        fastmap.clear();
+        map.clear();
+        EXPECT_EQ(fastmap.begin(), fastmap.end());
+    }
+    fastmap[1] = make_value<Value>(1);
+    Fastmap moved(std::move(fastmap));
+    EXPECT_EQ(moved.size(), 1);
+    fastmap.clear();  // the moved-from map shares the allocator but holds no entries
+    EXPECT_EQ(*moved.find(1), make_value<Value>(1));
+}
+
+TEST(fastmap, slab_allocator) {
+    check_slab_allocator<int, yfast::utils::SlabAllocator<std::uint32_t>>();
+    check_slab_allocator<int, yfast::utils::ArenaAllocator<std::uint32_t>>();
+    check_slab_allocator<std::string, yfast::utils::ArenaAllocator<std::uint32_t>>();
+    check_slab_allocator<int, yfast::utils::HugePageSlabAllocator<std::uint32_t>>();
+    // entries come from a node pool, buckets from the arena
+    check_slab_allocator<int, yfast::utils::ArenaAllocator<std::uint32_t>, yfast::internal::CompactAVLBuckets<>>();
+}
+
+template <typename Thresholds>
+void check_thresholds() {
+    Fastmap32<int, yfast::internal::AVLBuckets, std::allocator<std::uint32_t>, Thresholds> fastmap;
+    std::map<std::uint32_t, int> map;
+    churn(fastmap, map, 20000);
+    for (auto i = map.begin(); i != map.end(); i = map.erase(i)) {
+        EXPECT_EQ(fastmap.find(i->first).key(), i->first);
+        fastmap.erase(i->first);
+    }
+    EXPECT_TRUE(fastmap.empty());
+}
+
+TEST(fastmap, fixed_thresholds) {
+    check_thresholds<yfast::internal::FixedThresholds<8, 2>>();
+    check_thresholds<yfast::internal::FixedThresholds<256, 4>>();
+    // buckets of a single entry are only ever dropped, never merged
+    check_thresholds<yfast::internal::FixedThresholds<8, 1>>();
+}
+
+TEST(fastmap, adaptive_thresholds) {
+    check_thresholds<yfast::internal::AdaptiveThresholds<4, 256>>();
+
+    // overwriting values takes no rebuilds, so buckets get smaller
+    Fastmap32<int, yfast::internal::AVLBuckets, std::allocator<std::uint32_t>, yfast::internal::AdaptiveThresholds<>> fastmap;
+    EXPECT_EQ(fastmap.split_threshold(), 64);
+    for (std::uint32_t k = 0; k < 10000; ++k) {
+        fastmap[k] = 0;
+    }
+    const auto split_threshold = fastmap.split_threshold();
+    for (auto i = 1; i <= 3; ++i) {
+        for (std::uint32_t k = 0; k < 10000; ++k) {
+            fastmap.insert(k, i);
+        }
+    }
+    EXPECT_LT(fastmap.split_threshold(), split_threshold);
+    EXPECT_EQ(fastmap.size(), 10000);
+    EXPECT_EQ(*fastmap.find(5000), 3);
+}
+
+TEST(fastmap, cursor) {
+    yfast::fastmap<std::uint32_t, std::uint32_t, 32> fastmap;
+    auto cursor = fastmap.make_cursor();
+    EXPECT_EQ(cursor.find(0), fastmap.end());
+    EXPECT_EQ(cursor.succ(0), fastmap.end());
+    for (std::uint32_t key = 0; key < 10000; key += 3) {
+        fastmap[key] = key;
+    }
+    for (std::uint32_t key = 0; key < 10010; ++key) {
+        EXPECT_EQ(cursor.find(key), fastmap.find(key));
+        EXPECT_EQ(cursor.pred(key), fastmap.pred(key));
+        EXPECT_EQ(cursor.pred(key, true), fastmap.pred(key, true));
+        EXPECT_EQ(cursor.succ(key), fastmap.succ(key));
+        EXPECT_EQ(cursor.succ(key, true), fastmap.succ(key, true));
+    }
+    for (std::uint32_t key = 10010; key > 0; key -= 7) {
+        EXPECT_EQ(cursor.lower_bound(key), fastmap.lower_bound(key));
+        EXPECT_EQ(cursor.upper_bound(key), fastmap.upper_bound(key));
+        if (key % 2 == 0) {
+            fastmap.erase(key - key % 3);
+        }
+    }
+    for (std::uint32_t key = 5000; key < 9000; key += 11) {
+        EXPECT_EQ(cursor.pred(key, true), fastmap.pred(key, true));
+    }
+    fastmap.clear();
+    EXPECT_EQ(cursor.pred(100), fastmap.end());
+
+    const auto& const_fastmap = fastmap;
+    auto const_cursor = const_fastmap.make_cursor();
+    fastmap[1] = 1;
+    EXPECT_EQ(const_cursor.find(1), const_fastmap.find(1));
+}
+
+template <typename Fastmap>
+void check_wide_keys() {
+    typedef typename Fastmap::key_type Key;
+    Fastmap fastmap;
+    std::map<Key, int> map;
+    Key key = 1;
+    for (auto i = 0; i < 1000; ++i) {
+        key = key * 6364136223846793005ULL + 1442695040888963407ULL;  // spans all the bits, the top ones included
+        fastmap[key] = i;
+        map[key] = i;
+    }
+    for (auto i = map.begin(); i != map.end(); ) {
+        fastmap.erase(i->first);
+        i = map.erase(i);
+        if (i != map.end()) {
+            ++i;
+        }
+    }
+    EXPECT_EQ(fastmap.size(), map.size());
+    auto j = map.begin();
+    for (auto i = fastmap.begin(); i != fastmap.end(); ++i) {
+        ASSERT_NE(j, map.end());
+        EXPECT_TRUE(i.key() == j->first);
+        EXPECT_EQ(*i, j->second);
+        EXPECT_EQ(fastmap.pred(i.key() + 1), i);
+        EXPECT_EQ(fastmap.succ(i.key() - 1), i);
+        EXPECT_EQ(fastmap.find(i.key() + 1), fastmap.end());
+        ++j;
+    }
+}
+
+TEST(fastmap, uint64) {
+    check_wide_keys<yfast::fastmap<std::uint64_t, int, 64>>();
+    check_wide_keys<yfast::fastmap<std::uint64_t, int, 64, yfast::internal::BitExtractor<std::uint64_t>, yfast::internal::UnifiedLevels<>>>();
+    check_wide_keys<yfast::fastmap<std::uint64_t, int, 64, yfast::internal::BitExtractor<std::uint64_t>, yfast::internal::DirectTopLevels<>>>();
+}
+
+#ifdef __SIZEOF_INT128__
+TEST(fastmap, uint128) {
+    typedef yfast::internal::UInt128 UInt128;
+    check_wide_keys<yfast::fastmap<UInt128, int, 128>>();
+    check_wide_keys<yfast::fastmap<UInt128, int, 128, yfast::internal::BitExtractor<UInt128>, yfast::internal::UnifiedLevels<>>>();
+    check_wide_keys<yfast::fastmap<UInt128, int, 128, yfast::internal::BitExtractor<UInt128>, yfast::internal::DirectTopLevels<>>>();
+}
+#endif
+
+TEST(fastmap, inline_bit_extractor) {
+    typedef yfast::internal::BitExtractor<std::string> BitExtractor;
+    typedef yfast::internal::InlineBitExtractor<std::string, 8> InlineBitExtractor;
+    for (const std::string key: {"", "a", "key12345", "\xff\x01\x80"}) {
+        for (unsigned int n = 0; n < 64; ++n) {
+            const auto expected = BitExtractor::shift(key, n);
+            const auto shifted = InlineBitExtractor::shift(key, n);
+            ASSERT_EQ(shifted.size(), expected.size());
+            EXPECT_TRUE(std::equal(expected.begin(), expected.end(), shifted.data()));
+            EXPECT_EQ(InlineBitExtractor::extract_bit(key, n), BitExtractor::extract_bit(key, n));
+        }
+    }
+    EXPECT_THROW(InlineBitExtractor::shift("key123456", 0), std::length_error);
+
+    yfast::fastmap<std::string, int, 64, InlineBitExtractor> fastmap;
+    std::map<std::string, int> map;
+    for (auto i = 0; i < 1000; i += 3) {
+        const auto key = "key" + std::to_string(10000 + i);
+        fastmap[key] = i;
+        map[key] = i;
+    }
+    EXPECT_EQ(fastmap.size(), map.size());
+    for (auto i = 0; i < 1000; ++i) {
+        const auto key = "key" + std::to_string(10000 + i);
+        EXPECT_EQ(fastmap.find(key) != fastmap.end(), map.contains(key));
+        EXPECT_EQ(fastmap.succ(key).key(), map.lower_bound(key)->first);
+    }
+}
+
+TEST(fastmap, hashed_bit_extractor) {
+    typedef yfast::internal::BitExtractor<std::string> BitExtractor;
+    typedef yfast::internal::HashedBitExtractor<std::string, 16> HashedBitExtractor;
+    const std::vector<std::string> keys = {"", "a", "b", "key12345", "key12346", "\xff\x01\x80", "0123456789abcdef"};
+    for (const auto& key1: keys) {
+        for (const auto& key2: keys) {
+            for (unsigned int n = 0; n < 128; ++n) {
+                const auto prefix1 = HashedBitExtractor::shift(key1, n);
+                const auto prefix2 = HashedBitExtractor::shift(key2, n);
+                const auto equal = BitExtractor::shift(key1, n) == BitExtractor::shift(key2, n);
+                EXPECT_EQ(prefix1 == prefix2, equal);
+                if (equal) {
+                    EXPECT_EQ(std::hash<yfast::internal::HashedPrefix>()(prefix1), std::hash<yfast::internal::HashedPrefix>()(prefix2));
+                }
+                const auto copy = prefix1;
+                EXPECT_EQ(copy == prefix2, equal);
+            }
+        }
+    }
+    EXPECT_THROW(HashedBitExtractor::shift("0123456789abcdefg", 0), std::length_error);
+
+    yfast::fastmap<std::string, int, 128, HashedBitExtractor> fastmap;
+    std::map<std::string, int> map;
+    for (auto i = 0; i < 1000; i += 3) {
+        const auto key = "hashed-key-" + std::to_string(10000 + i);
+        fastmap[key] = i;
+        map[key] = i;
+    }
+    for (auto i = 0; i < 1000; i += 7) {
+        const auto key = "hashed-key-" + std::to_string(10000 + i);
+        EXPECT_EQ(fastmap.erase(key), map.erase(key));
+    }
+    EXPECT_EQ(fastmap.size(), map.size());
+    for (auto i = 0; i < 1000; ++i) {
+        const auto key = "hashed-key-" + std::to_string(10000 + i);
+        EXPECT_EQ(fastmap.find(key) != fastmap.end(), map.contains(key));
+        EXPECT_EQ(fastmap.succ(key).key(), map.lower_bound(key)->first);
+    }
+}
+
+template <typename BitExtractor>
+void check_transparent_lookup() {
+    typedef yfast::internal::DefaultHash<typename BitExtractor::ShiftResult, std::uintptr_t> Hash;
+    yfast::fastmap<std::string, int, 128, BitExtractor, Hash, std::less<>> fastmap;
+    std::map<std::string, int, std::less<>> map;
+    for (auto i = 0; i < 1000; i += 3) {
+        const auto key = "view-key-" + std::to_string(10000 + i);
+        fastmap[key] = i;
+        map[key] = i;
+    }
+    for (auto i = 0; i < 1000; i += 7) {
+        const auto key = "view-key-" + std::to_string(10000 + i);
+        EXPECT_EQ(fastmap.erase(std::string_view(key)), map.erase(key) > 0);
+    }
+    EXPECT_EQ(fastmap.size(), map.size());
+    auto cursor = fastmap.make_cursor();
+    for (auto i = 0; i < 1000; ++i) {
+        const auto key = "view-key-" + std::to_string(10000 + i);
+        const std::string_view view = key;
+        EXPECT_EQ(fastmap.find(view) != fastmap.end(), map.contains(view));
+        EXPECT_EQ(fastmap.find(key.c_str()) != fastmap.end(), map.contains(key.c_str()));
+        EXPECT_EQ(cursor.find(view) != fastmap.end(), map.contains(view));
+        EXPECT_EQ(fastmap.lower_bound(view).key(), map.lower_bound(view)->first);
+        auto upper = map.upper_bound(view);
+        if (upper != map.end()) {
+            EXPECT_EQ(fastmap.upper_bound(view).key(), upper->first);
+        }
+        if (map.begin()->first < view) {
+            EXPECT_EQ(fastmap.pred(view, true).key(), std::prev(map.lower_bound(view))->first);
+        }
+    }
+    EXPECT_EQ(fastmap.find("view-key-10003").value(), 3);
+    EXPECT_EQ(fastmap.succ("view-key-10000").key(), "view-key-10003");
+}
+
+TEST(fastmap, transparent_lookup) {
+    check_transparent_lookup<yfast::internal::BitExtractor<std::string>>();
+    check_transparent_lookup<yfast::internal::InlineBitExtractor<std::string, 16>>();
+    check_transparent_lookup<yfast::internal::HashedBitExtractor<std::string, 16>>();
+}
+
+template <std::size_t N>
+void check_fixed_width_keys() {
+    typedef std::array<std::byte, N> Key;
+    typedef yfast::internal::BitExtractor<Key> BitExtractor;
+    typedef yfast::internal::BitExtractor<std::vector<std::byte>> VectorBitExtractor;
+    constexpr unsigned int H = 8 * N;
+
+    std::vector<Key> keys(1000);
+    std::uint64_t state = 1;
+    for (auto& key: keys) {
+        for (auto& b: key) {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            b = static_cast<std::byte>(state >> 56);
+        }
+    }
+    for (std::size_t i = 1; i < 20; ++i) {
+        const auto& key1 = keys[i - 1];
+        auto key2 = key1;
+        key2[N - 1 - i % N] ^= std::byte{1};
+        for (unsigned int n = 0; n < H; ++n) {
+            EXPECT_EQ(BitExtractor::extract_bit(key1, n), VectorBitExtractor::extract_bit(key1.data(), N, n));
+            const auto equal = VectorBitExtractor::shift(key1.data(), N, n) == VectorBitExtractor::shift(key2.data(), N, n);
+            EXPECT_EQ(BitExtractor::shift(key1, n) == BitExtractor::shift(key2, n), equal);
+            EXPECT_TRUE(BitExtractor::prefixes(key1)(n) == BitExtractor::shift(key1, n));
+        }
+    }
+
+    yfast::fastmap<Key, int, H> fastmap;
+    std::map<Key, int> map;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        fastmap[keys[i]] = i;
+        map[keys[i]] = i;
+    }
+    for (std::size_t i = 0; i < keys.size(); i += 3) {
+        EXPECT_EQ(fastmap.erase(keys[i]), map.erase(keys[i]));
+    }
+    EXPECT_EQ(fastmap.size(), map.size());
+    for (const auto& key: keys) {
+        auto i = fastmap.succ(key);
+        auto j = map.lower_bound(key);
+        ASSERT_EQ(i == fastmap.end(), j == map.end());
+        if (j != map.end()) {
+            EXPECT_TRUE(i.key() == j->first);
+        }
+    }
+}
+
+TEST(fastmap, fixed_width_keys) {
+    check_fixed_width_keys<5>();
+    check_fixed_width_keys<8>();
+    check_fixed_width_keys<12>();
+    check_fixed_width_keys<16>();
+    check_fixed_width_keys<20>();
+    check_fixed_width_keys<32>();
+}
+
+template <typename Key>
+void check_ordered_keys(const std::vector<Key>& keys) {
+    yfast::fastmap<Key, int, 8 * sizeof(Key)> fastmap;
+    std::map<Key, int> map;
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        fastmap[keys[i]] = i;
+        map[keys[i]] = i;
+    }
+    EXPECT_EQ(fastmap.size(), map.size());
+    auto j = map.begin();
+    for (auto i = fastmap.begin(); i != fastmap.end(); ++i) {
+        ASSERT_NE(j, map.end());
+        EXPECT_EQ(i.key(), j->first);
+        EXPECT_EQ(*i, j->second);
+        ++j;
+    }
+    for (const auto& key: keys) {
+        EXPECT_EQ(fastmap.pred(key, true) == fastmap.end(), map.lower_bound(key) == map.begin());
+        EXPECT_EQ(fastmap.succ(key, true) == fastmap.end(), map.upper_bound(key) == map.end());
+    }
+}
+
+TEST(fastmap, signed_keys) {
+    std::vector<std::int32_t> keys32 = {INT32_MIN, INT32_MIN + 1, -65536, -1, 0, 1, 65536, INT32_MAX};
+    std::vector<std::int64_t> keys64 = {INT64_MIN, -(1LL << 40), -1, 0, 1, 1LL << 40, INT64_MAX};
+    std::int32_t key = 1;
+    for (auto i = 0; i < 1000; ++i) {
+        key = static_cast<std::int32_t>(static_cast<std::uint32_t>(key) * 1664525 + 1013904223);
+        keys32.push_back(key);
+        keys64.push_back(static_cast<std::int64_t>(key) * key * (key < 0 ? -1 : 1));
+    }
+    check_ordered_keys(keys32);
+    check_ordered_keys(keys64);
+}
+
+TEST(fastmap, floating_point_keys) {
+    std::vector<double> keys = {-std::numeric_limits<double>::infinity(), std::numeric_limits<double>::lowest(), -1.5, -std::numeric_limits<double>::denorm_min(), -0.0, 0.0, std::numeric_limits<double>::denorm_min(), 1e-300, 0.25, 1.5, std::numeric_limits<double>::max(), std::numeric_limits<double>::infinity()};
+    std::uint32_t key = 1;
+    for (auto i = 0; i < 1000; ++i) {
+        key = key * 1664525 + 1013904223;
+        keys.push_back((static_cast<double>(key) - (1U << 31)) / 1024);
+    }
+    check_ordered_keys(keys);
+    check_ordered_keys(std::vector<float>(keys.begin(), keys.end()));
+
+    yfast::fastmap<double, int, 64> fastmap { {-0.0, 1} };
+    EXPECT_EQ(fastmap.find(0.0).value(), 1);
+}
+
+TEST(fastmap, composite_keys) {
+    typedef std::pair<std::uint16_t, std::uint32_t> Pair;
+    typedef yfast::internal::CompositeBitExtractor<Pair, 16, 32> PairBitExtractor;
+    static_assert(PairBitExtractor::KeyLength == 48);
+    yfast::fastmap<Pair, int, PairBitExtractor::KeyLength, PairBitExtractor> pairs;
+    std::map<Pair, int> pair_map;
+
+    typedef std::tuple<std::int8_t, std::uint32_t, std::int16_t> Tuple;
+    typedef yfast::internal::CompositeBitExtractor<Tuple, 8, 24, 12> TupleBitExtractor;
+    yfast::fastmap<Tuple, int, TupleBitExtractor::KeyLength, TupleBitExtractor> tuples;
+    std::map<Tuple, int> tuple_map;
+
+    std::uint32_t state = 1;
+    for (auto i = 0; i < 1000; ++i) {
+        state = state * 1664525 + 1013904223;
+        const Pair pair { static_cast<std::uint16_t>(state % 7), state >> 3 };
+        pairs[pair] = i;
+        pair_map[pair] = i;
+        const Tuple tuple { static_cast<std::int8_t>(state % 11 - 5), (state >> 8) % 1000, static_cast<std::int16_t>((state >> 20) - 2048) };
+        tuples[tuple] = i;
+        tuple_map[tuple] = i;
+    }
+
+    auto j = pair_map.begin();
+    for (auto i = pairs.begin(); i != pairs.end(); ++i, ++j) {
+        ASSERT_NE(j, pair_map.end());
+        EXPECT_EQ(i.key(), j->first);
+    }
+    auto k = tuple_map.begin();
+    for (auto i = tuples.begin(); i != tuples.end(); ++i, ++k) {
+        ASSERT_NE(k, tuple_map.end());
+        EXPECT_EQ(i.key(), k->first);
+    }
+
+    // all the keys with the first field equal to 3
+    auto first = pairs.lower_bound({3, 0});
+    auto last = pairs.upper_bound({3, UINT32_MAX});
+    EXPECT_EQ(first.key(), pair_map.lower_bound({3, 0})->first);
+    EXPECT_EQ(last.key(), pair_map.upper_bound({3, UINT32_MAX})->first);
+}
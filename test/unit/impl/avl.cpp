@@ -1,3 +1,6 @@
+#include <bit>
+#include <cstdint>
+#include <vector>
 #include <utility>
 
 #include <yfast/impl/avl.h>
@@ -178,3 +181,85 @@ TEST(avl, merge_skew_right) {
     EXPECT_EQ(subtree1.root(), nullptr);
     EXPECT_EQ(subtree2.root(), nullptr);
 }
+
+TEST(avl, build) {
+    for (auto n = 0; n < 70; ++n) {
+        std::vector<AVLNode*> nodes;
+        for (auto key = 0; key < n; ++key) {
+            nodes.push_back(new AVLNode(2 * key));
+        }
+        auto tree = yfast::impl::AVL<AVLNode>::build(nodes);
+        EXPECT_EQ(tree.size(), n);
+        EXPECT_EQ(tree.height(), std::bit_width(static_cast<unsigned int>(n)));
+        auto key = 0;
+        for (auto node = tree.leftmost(); node != nullptr; node = yfast::impl::AVL<AVLNode>::succ(node)) {
+            EXPECT_EQ(node->key, key);
+            key += 2;
+        }
+        EXPECT_EQ(key, 2 * n);
+        if (n > 0) {
+            EXPECT_EQ(tree.root()->size, n);
+        }
+
+        // balance factors are right, so the tree stays balanced under updates
+        for (auto k = 1; k < 2 * n; k += 2) {
+            tree.insert(new AVLNode(k));
+        }
+        EXPECT_EQ(tree.size(), 2 * n);
+        EXPECT_LE(tree.height(), std::bit_width(static_cast<unsigned int>(2 * n)) + 1);
+        for (auto node: nodes) {
+            tree.remove(node);
+        }
+        EXPECT_EQ(tree.size(), n);
+    }
+}
+
+template <bool SubtreeSizes>
+struct CompactAVLNode: public yfast::internal::AVLNodeBase<int, CompactAVLNode<SubtreeSizes>, yfast::internal::CompactBSTNodeBase<int, CompactAVLNode<SubtreeSizes>, SubtreeSizes>> {
+    explicit CompactAVLNode(int key): CompactAVLNode::AVLNodeBase(key) {}
+};
+
+template <bool SubtreeSizes>
+void check_compact() {
+    typedef CompactAVLNode<SubtreeSizes> Node;
+    typedef yfast::impl::AVL<Node> AVL;
+    typename Node::Allocator alloc;
+
+    AVL tree;
+    for (auto key = 0; key < 100; ++key) {
+        tree.insert(new (alloc.allocate(1)) Node((key * 37) % 100));
+    }
+    EXPECT_EQ(tree.size(), 100);
+    EXPECT_LE(tree.height(), 9);
+    for (auto key = 0; key < 100; key += 3) {
+        auto node = tree.find(key);
+        ASSERT_NE(node, nullptr);
+        tree.remove(node);
+        alloc.deallocate(node, 1);
+    }
+    EXPECT_EQ(tree.size(), 66);
+
+    auto split_result = tree.split();
+    EXPECT_EQ(tree.size(), 0);
+    EXPECT_EQ(split_result.left.size() + split_result.right.size(), 66);
+    EXPECT_EQ(split_result.left.rightmost(), split_result.left_max);
+    if constexpr (SubtreeSizes) {
+        EXPECT_EQ(split_result.left.root()->size, split_result.left.size());
+        EXPECT_EQ(split_result.right.root()->size, split_result.right.size());
+    }
+
+    auto merged = AVL::merge(std::move(split_result.right), std::move(split_result.left));
+    EXPECT_EQ(merged.size(), 66);
+    auto key = 1;
+    for (auto node = merged.leftmost(); node != nullptr; node = AVL::succ(node)) {
+        EXPECT_EQ(node->key, key);
+        key += key % 3 == 1 ? 1 : 2;
+    }
+    EXPECT_EQ(key, 100);
+}
+
+TEST(avl, compact) {
+    EXPECT_EQ(sizeof(CompactAVLNode<false>), 4 * sizeof(std::uint32_t));
+    check_compact<false>();
+    check_compact<true>();
+}
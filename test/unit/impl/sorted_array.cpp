@@ -0,0 +1,206 @@
+#include <utility>
+#include <vector>
+
+#include <yfast/impl/sorted_array.h>
+
+#include <gtest/gtest.h>
+
+struct Node {
+    typedef int Key;
+
+    const Key key;
+
+    explicit Node(int key): key(key) {}
+};
+
+typedef yfast::impl::SortedArray<Node, 64> SortedArray;
+
+TEST(sorted_array, empty) {
+    SortedArray array;
+    EXPECT_EQ(array.size(), 0);
+    EXPECT_EQ(array.root(), nullptr);
+    EXPECT_EQ(array.leftmost(), nullptr);
+    EXPECT_EQ(array.rightmost(), nullptr);
+    EXPECT_EQ(array.find(0), nullptr);
+    EXPECT_EQ(array.pred(0), nullptr);
+    EXPECT_EQ(array.succ(0), nullptr);
+}
+
+TEST(sorted_array, split_empty) {
+    SortedArray array;
+    auto split_result = array.split();
+    EXPECT_EQ(array.size(), 0);
+    EXPECT_EQ(split_result.left.size(), 0);
+    EXPECT_EQ(split_result.right.size(), 0);
+    EXPECT_EQ(split_result.left_max, nullptr);
+}
+
+TEST(sorted_array, insert) {
+    SortedArray array;
+    for (auto key: {5, 1, 9, 3, 7}) {
+        EXPECT_EQ(array.insert(new Node(key)), nullptr);
+    }
+    EXPECT_EQ(array.size(), 5);
+    auto key = 1;
+    for (auto node: array.nodes()) {
+        EXPECT_EQ(node->key, key);
+        key += 2;
+    }
+    EXPECT_EQ(array.root()->key, 5);
+    EXPECT_EQ(array.leftmost()->key, 1);
+    EXPECT_EQ(array.rightmost()->key, 9);
+}
+
+TEST(sorted_array, replace) {
+    SortedArray array;
+    auto node = new Node(1);
+    array.insert(node);
+    array.insert(new Node(2));
+    auto replacement = new Node(1);
+    EXPECT_EQ(array.insert(replacement), node);
+    EXPECT_EQ(array.size(), 2);
+    EXPECT_EQ(array.find(1), replacement);
+}
+
+TEST(sorted_array, lookup) {
+    SortedArray array;
+    for (auto key = 0; key < 60; key += 2) {
+        array.insert(new Node(key));
+    }
+    for (auto key = -1; key < 61; ++key) {
+        auto found = array.find(key);
+        if (key >= 0 && key < 60 && key % 2 == 0) {
+            ASSERT_NE(found, nullptr);
+            EXPECT_EQ(found->key, key);
+        }
+        else {
+            EXPECT_EQ(found, nullptr);
+        }
+
+        auto pred = array.pred(key);
+        auto pred_strict = array.pred(key, true);
+        auto succ = array.succ(key);
+        auto succ_strict = array.succ(key, true);
+        const auto max = 58;
+        if (key < 0) {
+            EXPECT_EQ(pred, nullptr);
+            EXPECT_EQ(pred_strict, nullptr);
+        }
+        else {
+            EXPECT_EQ(pred->key, std::min(key - key % 2, max));
+            if (key == 0) {
+                EXPECT_EQ(pred_strict, nullptr);
+            }
+            else {
+                EXPECT_EQ(pred_strict->key, std::min((key - 1) - (key - 1) % 2, max));
+            }
+        }
+        if (key > max) {
+            EXPECT_EQ(succ, nullptr);
+        }
+        else {
+            EXPECT_EQ(succ->key, std::max(key + key % 2, 0));
+        }
+        if (key >= max) {
+            EXPECT_EQ(succ_strict, nullptr);
+        }
+        else {
+            EXPECT_EQ(succ_strict->key, std::max(key + 2 - (key + 2) % 2, 0));
+        }
+    }
+}
+
+TEST(sorted_array, step) {
+    SortedArray array;
+    for (auto key = 0; key < 10; ++key) {
+        array.insert(new Node(key));
+    }
+    auto node = array.leftmost();
+    EXPECT_EQ(array.pred(node), nullptr);
+    for (auto key = 1; key < 10; ++key) {
+        auto succ = array.succ(node);
+        ASSERT_NE(succ, nullptr);
+        EXPECT_EQ(succ->key, key);
+        EXPECT_EQ(array.pred(succ), node);
+        node = succ;
+    }
+    EXPECT_EQ(array.succ(node), nullptr);
+}
+
+TEST(sorted_array, remove) {
+    SortedArray array;
+    for (auto key = 0; key < 10; ++key) {
+        array.insert(new Node(key));
+    }
+    for (auto key = 0; key < 10; key += 3) {
+        auto node = array.find(key);
+        array.remove(node);
+        delete node;
+    }
+    EXPECT_EQ(array.size(), 6);
+    for (auto key = 0; key < 10; ++key) {
+        EXPECT_EQ(array.find(key) != nullptr, key % 3 != 0);
+    }
+}
+
+TEST(sorted_array, split) {
+    SortedArray array;
+    for (auto key = 0; key < 9; ++key) {
+        array.insert(new Node(key));
+    }
+    auto root = array.root();
+    auto split_result = array.split();
+    EXPECT_EQ(array.size(), 0);
+    EXPECT_EQ(split_result.left_max, root);
+    EXPECT_EQ(split_result.left.size(), 5);
+    EXPECT_EQ(split_result.right.size(), 4);
+    EXPECT_EQ(split_result.left.rightmost(), root);
+    EXPECT_EQ(split_result.right.leftmost()->key, 5);
+}
+
+TEST(sorted_array, merge) {
+    SortedArray left;
+    SortedArray right;
+    for (auto key = 0; key < 5; ++key) {
+        left.insert(new Node(key));
+        right.insert(new Node(key + 5));
+    }
+    auto merged = SortedArray::merge(std::move(right), std::move(left));
+    EXPECT_EQ(merged.size(), 10);
+    EXPECT_EQ(left.size(), 0);
+    EXPECT_EQ(right.size(), 0);
+    auto key = 0;
+    for (auto node: merged.nodes()) {
+        EXPECT_EQ(node->key, key++);
+    }
+}
+
+TEST(sorted_array, merge_empty) {
+    SortedArray empty;
+    SortedArray array;
+    for (auto key = 0; key < 5; ++key) {
+        array.insert(new Node(key));
+    }
+    auto merged = SortedArray::merge(std::move(empty), std::move(array));
+    EXPECT_EQ(merged.size(), 5);
+    EXPECT_EQ(array.size(), 0);
+    auto merged_again = SortedArray::merge(std::move(merged), SortedArray());
+    EXPECT_EQ(merged_again.size(), 5);
+    EXPECT_EQ(merged_again.leftmost()->key, 0);
+    EXPECT_EQ(merged_again.rightmost()->key, 4);
+    EXPECT_EQ(SortedArray::merge(SortedArray(), SortedArray()).size(), 0);
+}
+
+TEST(sorted_array, build) {
+    std::vector<Node*> nodes;
+    for (auto key = 0; key < 9; ++key) {
+        nodes.push_back(new Node(3 * key));
+    }
+    auto array = SortedArray::build(nodes);
+    EXPECT_EQ(array.size(), 9);
+    EXPECT_EQ(array.root(), nodes[4]);
+    EXPECT_EQ(array.find(12), nodes[4]);
+    EXPECT_EQ(array.pred(13), nodes[4]);
+    array.insert(new Node(13));
+    EXPECT_EQ(array.succ(12, true)->key, 13);
+}
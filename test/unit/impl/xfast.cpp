@@ -1,3 +1,8 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+
 #include <yfast/impl/xfast.h>
 #include <yfast/internal/xfast.h>
 
@@ -5,6 +10,65 @@
 
 struct XFastLeaf: public yfast::internal::XFastLeafBase<int, XFastLeaf> {};
 
+// only provides the bare yfast::internal::MapGeneric interface
+class PlainMap {
+    std::unordered_map<int, std::uintptr_t> _map;
+
+public:
+    std::uintptr_t& operator [] (int key) { return _map[key]; }
+    std::uintptr_t at(int key) const { return _map.at(key); }
+    [[nodiscard]] bool contains(int key) const { return _map.contains(key); }
+    [[nodiscard]] std::size_t size() const { return _map.size(); }
+    void erase(int key) { _map.erase(key); }
+    void clear() { _map.clear(); }
+};
+
+// counts the bytes currently allocated through it and its copies
+template <typename T>
+struct CountingAllocator {
+    typedef T value_type;
+
+    std::shared_ptr<std::ptrdiff_t> bytes;
+
+    CountingAllocator(): bytes(std::make_shared<std::ptrdiff_t>(0)) {}
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other): bytes(other.bytes) {}
+
+    T* allocate(std::size_t n) {
+        *bytes += n * sizeof(T);
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* ptr, std::size_t n) {
+        *bytes -= n * sizeof(T);
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    template <typename U>
+    bool operator == (const CountingAllocator<U>& other) const { return bytes == other.bytes; }
+};
+
+template <typename Hash>
+void check_allocator() {
+    CountingAllocator<int> alloc;
+    {
+        yfast::impl::XFastTrie<XFastLeaf, 8, yfast::internal::BitExtractor<int>, Hash, std::less<int>, CountingAllocator<int>> trie({}, {}, alloc);
+        XFastLeaf* leaves[16];
+        for (auto i = 0; i < 16; ++i) {
+            leaves[i] = new XFastLeaf { 16 * i + 1 };
+            trie.insert(leaves[i]);
+        }
+        EXPECT_GT(*alloc.bytes, 0);
+        EXPECT_EQ(trie.find(49), leaves[3]);
+        trie.clear();
+        for (auto leaf: leaves) {
+            delete leaf;
+        }
+    }
+    EXPECT_EQ(*alloc.bytes, 0);
+}
+
 TEST(xfast, empty) {
     yfast::impl::XFastTrie<XFastLeaf, 8> trie;
     EXPECT_EQ(trie.size(), 0);
@@ -33,3 +97,100 @@ TEST(xfast, replace) {
     }
     EXPECT_NE(trie.insert(new XFastLeaf { 2 }), nullptr);
 }
+
+TEST(xfast, plain_map) {
+    yfast::impl::XFastTrie<XFastLeaf, 8, yfast::internal::BitExtractor<int>, PlainMap> trie;
+    XFastLeaf* leaves[16];
+    for (auto i = 0; i < 16; ++i) {
+        leaves[i] = new XFastLeaf { 2 * i };
+        trie.insert(leaves[i]);
+    }
+    EXPECT_EQ(trie.size(), 16);
+    EXPECT_EQ(trie.find(6), leaves[3]);
+    EXPECT_EQ(trie.find(7), nullptr);
+    EXPECT_EQ(trie.pred(7), leaves[3]);
+    EXPECT_EQ(trie.succ(7), leaves[4]);
+
+    trie.remove(leaves[4]);
+    EXPECT_EQ(trie.find(8), nullptr);
+    EXPECT_EQ(trie.succ(7), leaves[5]);
+}
+
+TEST(xfast, unified_levels) {
+    yfast::impl::XFastTrie<XFastLeaf, 8, yfast::internal::BitExtractor<int>, yfast::internal::UnifiedLevels<>> trie;
+    trie.reserve(16);
+    XFastLeaf* leaves[16];
+    for (auto i = 0; i < 16; ++i) {
+        leaves[i] = new XFastLeaf { 2 * i };
+        trie.insert(leaves[i]);
+    }
+    EXPECT_EQ(trie.size(), 16);
+    EXPECT_EQ(trie.insert(new XFastLeaf { 6 }), leaves[3]);
+    EXPECT_EQ(trie.size(), 16);
+    EXPECT_EQ(trie.find(7), nullptr);
+    EXPECT_EQ(trie.pred(7)->key, 6);
+    EXPECT_EQ(trie.succ(7), leaves[4]);
+
+    trie.remove(leaves[4]);
+    EXPECT_EQ(trie.size(), 15);
+    EXPECT_EQ(trie.find(8), nullptr);
+    EXPECT_EQ(trie.succ(7), leaves[5]);
+
+    trie.clear();
+    EXPECT_EQ(trie.size(), 0);
+    EXPECT_EQ(trie.pred(7), nullptr);
+}
+
+TEST(xfast, direct_top_levels) {
+    yfast::impl::XFastTrie<XFastLeaf, 8, yfast::internal::BitExtractor<int>, yfast::internal::DirectTopLevels<>> trie;
+    EXPECT_EQ(trie.pred(7), nullptr);
+    XFastLeaf* leaves[16];
+    for (auto i = 0; i < 16; ++i) {
+        leaves[i] = new XFastLeaf { 16 * i + 1 };
+        trie.insert(leaves[i]);
+    }
+    EXPECT_EQ(trie.size(), 16);
+    EXPECT_EQ(trie.find(49), leaves[3]);
+    EXPECT_EQ(trie.pred(50), leaves[3]);
+    EXPECT_EQ(trie.succ(50), leaves[4]);
+    EXPECT_EQ(trie.succ(242), nullptr);
+
+    trie.remove(leaves[4]);
+    trie.remove(leaves[15]);
+    EXPECT_EQ(trie.size(), 14);
+    EXPECT_EQ(trie.succ(50), leaves[5]);
+    EXPECT_EQ(trie.pred(255), leaves[14]);
+
+    trie.clear();
+    EXPECT_EQ(trie.size(), 0);
+    EXPECT_EQ(trie.succ(0), nullptr);
+}
+
+TEST(xfast, batch) {
+    yfast::impl::XFastTrie<XFastLeaf, 8> trie;
+    int keys[40];
+    XFastLeaf* leaves[40];
+    trie.pred_batch(std::span(keys, 0), std::span(leaves, 0));
+    for (auto i = 0; i < 40; ++i) {
+        keys[i] = 6 * i + 1;
+    }
+    trie.succ_batch(keys, leaves);
+    EXPECT_EQ(leaves[0], nullptr);
+    for (auto i = 0; i < 20; ++i) {
+        trie.insert(new XFastLeaf { 12 * i });
+    }
+    trie.pred_batch(keys, leaves);
+    for (auto i = 0; i < 40; ++i) {
+        EXPECT_EQ(leaves[i], trie.pred(keys[i]));
+    }
+    trie.succ_batch(keys, leaves, true);
+    for (auto i = 0; i < 40; ++i) {
+        EXPECT_EQ(leaves[i], trie.succ(keys[i], true));
+    }
+}
+
+TEST(xfast, allocator) {
+    check_allocator<yfast::internal::DefaultHash<int, std::uintptr_t>>();
+    check_allocator<yfast::internal::UnifiedLevels<>>();
+    check_allocator<yfast::internal::DirectTopLevels<>>();
+}
@@ -1,3 +1,4 @@
+#include <set>
 #include <unordered_map>
 
 #include <yfast/impl/yfast.h>
@@ -111,3 +112,100 @@ TEST(yfast, xleaf_size) {
         EXPECT_GE(xleaf->value.size(), 5);
     }
 }
+
+TEST(yfast, xleaf_extremes) {
+    yfast::impl::YFastTrie<YFastLeaf, 16> trie;
+    std::unordered_map<int, YFastLeaf*> leaves;
+    unsigned int key = 1;
+    for (auto i = 0; i < 20'000; ++i) {
+        key = key * 1664525 + 1013904223;
+        const int k = key % 4096;
+        auto found = leaves.find(k);
+        if (found == leaves.end()) {
+            auto leaf = new YFastLeaf(k);
+            trie.insert(leaf);
+            leaves[k] = leaf;
+        }
+        else if (i % 2 == 0) {
+            trie.remove(found->second);
+            delete found->second;
+            leaves.erase(found);
+        }
+        else {
+            auto leaf = new YFastLeaf(k);
+            EXPECT_EQ(trie.insert(leaf).leaf, found->second);
+            delete found->second;
+            found->second = leaf;
+        }
+    }
+    for (auto xleaf = trie.leftmost().xleaf; xleaf != nullptr; xleaf = xleaf->nxt) {
+        EXPECT_EQ(xleaf->min, xleaf->value.leftmost());
+        EXPECT_EQ(xleaf->max, xleaf->value.rightmost());
+    }
+}
+
+template <typename Buckets>
+void check_representatives() {
+    typedef yfast::internal::BitExtractor<int> BitExtractor;
+    typedef yfast::internal::DefaultHash<BitExtractor::ShiftResult, std::uintptr_t> Hash;
+    yfast::impl::YFastTrie<YFastLeaf, 16, BitExtractor, Hash, std::less<int>, std::allocator<int>, Buckets> trie;
+    std::unordered_map<int, YFastLeaf*> leaves;
+    std::set<int> keys;
+    unsigned int key = 1;
+    for (auto i = 0; i < 20'000; ++i) {
+        key = key * 1664525 + 1013904223;
+        const int k = key % 4096;
+        auto found = leaves.find(k);
+        if (found == leaves.end()) {
+            auto leaf = new YFastLeaf(k);
+            trie.insert(leaf);
+            leaves[k] = leaf;
+            keys.insert(k);
+        }
+        else {
+            trie.remove(found->second);
+            delete found->second;
+            leaves.erase(found);
+            keys.erase(k);
+        }
+    }
+    // erasing the lower part of a bucket leaves its representative out of range yet takes no rebuild
+    auto xleaf = trie.leftmost().xleaf->nxt;
+    const auto rebuilds = trie.rebuilds();
+    while (!(xleaf->key < xleaf->min->key)) {
+        auto leaf = xleaf->min;
+        keys.erase(leaf->key);
+        leaves.erase(leaf->key);
+        trie.remove(leaf, xleaf);
+        delete leaf;
+    }
+    EXPECT_EQ(trie.rebuilds(), rebuilds);
+
+    for (xleaf = trie.leftmost().xleaf->nxt; xleaf != nullptr; xleaf = xleaf->nxt) {
+        EXPECT_LT(xleaf->prv->max->key, xleaf->key);
+        if (yfast::internal::min_representatives_v<Buckets>) {
+            EXPECT_LE(xleaf->key, xleaf->min->key);
+        }
+    }
+    auto key_of = [] (auto where) { return where.leaf != nullptr ? where.leaf->key : -1; };
+    for (auto k = 0; k <= 4096; ++k) {
+        EXPECT_EQ(trie.find(k).leaf != nullptr, keys.contains(k));
+        auto succ = keys.lower_bound(k);
+        auto succ_strict = keys.upper_bound(k);
+        EXPECT_EQ(key_of(trie.succ(k)), succ != keys.end() ? *succ : -1);
+        EXPECT_EQ(key_of(trie.succ(k, true)), succ_strict != keys.end() ? *succ_strict : -1);
+        EXPECT_EQ(key_of(trie.pred(k)), succ_strict != keys.begin() ? *std::prev(succ_strict) : -1);
+        EXPECT_EQ(key_of(trie.pred(k, true)), succ != keys.begin() ? *std::prev(succ) : -1);
+    }
+    for (const auto& [k, leaf]: leaves) {
+        delete leaf;
+    }
+}
+
+TEST(yfast, lazy_representatives) {
+    check_representatives<yfast::internal::AVLBuckets>();
+}
+
+TEST(yfast, min_representatives) {
+    check_representatives<yfast::internal::MinimumRepresentatives<>>();
+}
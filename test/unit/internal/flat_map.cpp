@@ -0,0 +1,107 @@
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <yfast/internal/flat_map.h>
+
+#include <gtest/gtest.h>
+
+typedef yfast::internal::FlatMap<std::uint64_t, std::uintptr_t> FlatMap;
+
+TEST(flat_map, empty) {
+    FlatMap map;
+    EXPECT_EQ(map.size(), 0);
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.begin(), map.end());
+    EXPECT_EQ(map.find(0), map.end());
+    EXPECT_FALSE(map.contains(0));
+    EXPECT_THROW(map.at(0), std::out_of_range);
+    EXPECT_EQ(map.erase(0), 0);
+}
+
+TEST(flat_map, insert_erase) {
+    FlatMap map;
+    map[1] = 10;
+    EXPECT_TRUE(map.try_emplace(2, 20).second);
+    EXPECT_FALSE(map.try_emplace(2, 30).second);
+    EXPECT_EQ(map.size(), 2);
+    EXPECT_EQ(map.at(1), 10);
+    EXPECT_EQ(map.at(2), 20);
+
+    auto i = map.find(1);
+    ASSERT_NE(i, map.end());
+    EXPECT_EQ(i->first, 1);
+    i->second = 11;
+    EXPECT_EQ(map.at(1), 11);
+
+    map.erase(i);
+    EXPECT_FALSE(map.contains(1));
+    EXPECT_EQ(map.erase(2), 1);
+    EXPECT_TRUE(map.empty());
+}
+
+TEST(flat_map, iterate) {
+    FlatMap map;
+    for (std::uint64_t i = 0; i < 100; ++i) {
+        map[i << 32] = i;
+    }
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    for (const auto& [key, value]: map) {
+        EXPECT_EQ(key, value << 32);
+        ++count;
+        sum += value;
+    }
+    EXPECT_EQ(count, 100);
+    EXPECT_EQ(sum, 99 * 100 / 2);
+}
+
+TEST(flat_map, clear_reserve) {
+    FlatMap map;
+    map.reserve(1000);
+    const auto capacity = map.capacity();
+    EXPECT_GE(capacity, 1000);
+    for (std::uint64_t i = 0; i < 1000; ++i) {
+        map[i] = i;
+    }
+    EXPECT_EQ(map.capacity(), capacity);
+    map.clear();
+    EXPECT_TRUE(map.empty());
+    EXPECT_EQ(map.capacity(), capacity);
+    EXPECT_FALSE(map.contains(0));
+}
+
+TEST(flat_map, move) {
+    FlatMap map;
+    map[1] = 1;
+    FlatMap other(std::move(map));
+    EXPECT_EQ(other.at(1), 1);
+    map = std::move(other);
+    EXPECT_EQ(map.at(1), 1);
+}
+
+TEST(flat_map, fuzz) {
+    FlatMap map;
+    std::unordered_map<std::uint64_t, std::uintptr_t> reference;
+    std::mt19937_64 rng(0);
+    for (auto i = 0; i < 100000; ++i) {
+        const std::uint64_t key = rng() % 4096;
+        switch (rng() % 3) {
+            case 0:
+                map[key] = i;
+                reference[key] = i;
+                break;
+            case 1:
+                EXPECT_EQ(map.erase(key), reference.erase(key));
+                break;
+            default:
+                EXPECT_EQ(map.contains(key), reference.contains(key));
+                break;
+        }
+        ASSERT_EQ(map.size(), reference.size());
+    }
+    for (const auto& [key, value]: reference) {
+        EXPECT_EQ(map.at(key), value);
+    }
+}
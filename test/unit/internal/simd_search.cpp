@@ -0,0 +1,57 @@
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <yfast/internal/simd_search.h>
+
+#include <gtest/gtest.h>
+
+template <typename Key>
+void check_count_less() {
+    std::mt19937_64 random(42);
+    std::vector<Key> keys(40);
+    for (auto& key: keys) {
+        key = static_cast<Key>(random());
+    }
+    // extremes catch signedness mistakes
+    keys[0] = std::numeric_limits<Key>::min();
+    keys[1] = std::numeric_limits<Key>::max();
+    keys[2] = 0;
+    keys[3] = static_cast<Key>(-1);
+    std::sort(keys.begin(), keys.end());
+    std::vector<Key> probes(keys);
+    for (auto key: keys) {
+        probes.push_back(key + 1);
+        probes.push_back(key - 1);
+    }
+    for (std::size_t n = 0; n <= keys.size(); ++n) {
+        for (auto probe: probes) {
+            const auto expected = yfast::internal::simd::count_less_scalar(keys.data(), n, probe);
+            ASSERT_EQ(expected, std::lower_bound(keys.begin(), keys.begin() + n, probe) - keys.begin());
+            ASSERT_EQ(yfast::internal::count_less(keys.data(), n, probe), expected);
+#ifdef YFAST_SIMD_AVX2_DISPATCH
+            if (__builtin_cpu_supports("avx2")) {
+                ASSERT_EQ(yfast::internal::simd::count_less_avx2(keys.data(), n, probe), expected);
+            }
+#endif
+        }
+    }
+}
+
+TEST(simd_search, uint32) {
+    check_count_less<std::uint32_t>();
+}
+
+TEST(simd_search, int32) {
+    check_count_less<std::int32_t>();
+}
+
+TEST(simd_search, uint64) {
+    check_count_less<std::uint64_t>();
+}
+
+TEST(simd_search, int64) {
+    check_count_less<std::int64_t>();
+}
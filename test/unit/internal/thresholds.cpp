@@ -0,0 +1,70 @@
+#include <yfast/internal/thresholds.h>
+
+#include <gtest/gtest.h>
+
+TEST(thresholds, fixed) {
+    typedef yfast::internal::DefaultThresholds::Thresholds<32> Default;
+    EXPECT_EQ(Default::split(), 64);
+    EXPECT_EQ(Default::merge(), 8);
+    EXPECT_EQ(Default::MAX_SPLIT, 64);
+    EXPECT_EQ(Default::MAX_MERGE, 8);
+
+    typedef yfast::internal::FixedThresholds<100, 10>::Thresholds<32> Fixed;
+    EXPECT_EQ(Fixed::split(), 100);
+    EXPECT_EQ(Fixed::merge(), 10);
+}
+
+TEST(thresholds, adaptive_grow) {
+    yfast::internal::AdaptiveThresholds<4, 100>::Thresholds<32> thresholds;
+    EXPECT_EQ(thresholds.split(), 64);
+    EXPECT_EQ(thresholds.merge(), 8);
+    // a rebuild every 10 updates outweighs the bucket searches
+    unsigned int rebuilds = 0;
+    for (auto i = 0; i < 100; ++i) {
+        rebuilds += i % 10 == 0;
+        thresholds.on_update(rebuilds, 0);
+    }
+    EXPECT_EQ(thresholds.split(), 128);
+    EXPECT_EQ(thresholds.merge(), 16);
+    for (auto i = 0; i < 1000; ++i) {
+        rebuilds += i % 10 == 0;
+        thresholds.on_update(rebuilds, 0);
+    }
+    EXPECT_EQ(thresholds.split(), decltype(thresholds)::MAX_SPLIT);
+}
+
+TEST(thresholds, adaptive_shrink) {
+    yfast::internal::AdaptiveThresholds<4, 100>::Thresholds<32> thresholds;
+    // no rebuilds at all
+    for (auto i = 0; i < 100; ++i) {
+        thresholds.on_update(0, 0);
+    }
+    EXPECT_EQ(thresholds.split(), 32);
+    for (auto i = 0; i < 1000; ++i) {
+        thresholds.on_update(0, 0);
+    }
+    EXPECT_EQ(thresholds.split(), 16);
+    EXPECT_EQ(thresholds.merge(), 2);
+}
+
+TEST(thresholds, adaptive_balanced) {
+    yfast::internal::AdaptiveThresholds<4, 1000>::Thresholds<32> thresholds;
+    // a rebuild every 1000 updates costs about as much as the bucket searches
+    unsigned int rebuilds = 0;
+    for (auto i = 0; i < 3000; ++i) {
+        rebuilds += i % 1000 == 0;
+        thresholds.on_update(rebuilds, 0);
+    }
+    EXPECT_EQ(thresholds.split(), 64);
+}
+
+TEST(thresholds, adaptive_epoch) {
+    yfast::internal::AdaptiveThresholds<4, 100>::Thresholds<32> thresholds;
+    // an epoch lasts as many updates as there are leaves
+    for (auto i = 0; i < 999; ++i) {
+        thresholds.on_update(0, 1000);
+    }
+    EXPECT_EQ(thresholds.split(), 64);
+    thresholds.on_update(0, 1000);
+    EXPECT_EQ(thresholds.split(), 32);
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include <yfast/internal/concepts.h>
+#include <yfast/utils/slab.h>
+
+#include <gtest/gtest.h>
+
+struct Node {
+    std::uint64_t key;
+    Node* next;
+    char payload[24];
+};
+
+TEST(slab, reuse) {
+    yfast::utils::SlabResource resource;
+    auto block1 = resource.allocate(40);
+    auto block2 = resource.allocate(40);
+    EXPECT_EQ(static_cast<char*>(block2) - static_cast<char*>(block1), 40);
+    resource.deallocate(block1, 40);
+    EXPECT_EQ(resource.allocate(37), block1);  // the same size class
+    EXPECT_NE(resource.allocate(48), block1);
+}
+
+TEST(slab, size_classes) {
+    yfast::utils::SlabResource resource;
+    std::set<std::uintptr_t> blocks;
+    for (std::size_t size = 1; size < 4096; size += 13) {
+        for (auto i = 0; i < 20; ++i) {
+            auto block = resource.allocate(size);
+            EXPECT_EQ(reinterpret_cast<std::uintptr_t>(block) % 8, 0);
+            EXPECT_TRUE(blocks.insert(reinterpret_cast<std::uintptr_t>(block)).second);
+            std::fill_n(static_cast<char*>(block), size, 0);
+        }
+    }
+    resource.release();
+    auto block = resource.allocate(8);
+    EXPECT_NE(block, nullptr);
+}
+
+TEST(slab, large_blocks) {
+    yfast::utils::SlabResource resource;
+    auto small = static_cast<char*>(resource.allocate(64));
+    auto large = static_cast<char*>(resource.allocate(std::size_t{1} << 20));
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(large) % 64, 0);
+    std::fill_n(large, std::size_t{1} << 20, 1);
+    resource.deallocate(large, std::size_t{1} << 20);  // its slab goes back right away
+    std::fill_n(small, 64, 1);
+    resource.deallocate(small, 64);
+    EXPECT_EQ(resource.allocate(64), small);
+}
+
+TEST(slab, huge_pages) {
+    yfast::utils::BasicSlabResource<yfast::utils::HugePages> resource;
+    auto block = static_cast<char*>(resource.allocate(sizeof(Node)));
+    auto large = static_cast<char*>(resource.allocate(std::size_t{3} << 20));
+#ifdef YFAST_HUGE_PAGES_MMAP
+    // blocks follow a 64-byte slab header at a 2 MiB boundary
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(block) % yfast::utils::HugePages::PAGE, 64);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(large) % yfast::utils::HugePages::PAGE, 64);
+#endif
+    std::fill_n(block, sizeof(Node), 1);
+    std::fill_n(large, std::size_t{3} << 20, 1);
+    resource.deallocate(large, std::size_t{3} << 20);
+
+    yfast::utils::HugePageSlabAllocator<Node> alloc;
+    std::vector<Node*> nodes;
+    for (std::uint64_t i = 0; i < 100000; ++i) {
+        nodes.push_back(alloc.allocate(1));
+        nodes.back()->key = i;
+    }
+    for (std::uint64_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_EQ(nodes[i]->key, i);
+    }
+}
+
+TEST(slab, allocator) {
+    yfast::utils::SlabAllocator<std::uint64_t> alloc;
+    std::allocator_traits<decltype(alloc)>::rebind_alloc<Node> node_alloc(alloc);
+    EXPECT_TRUE(alloc == node_alloc);
+    EXPECT_FALSE(alloc == yfast::utils::SlabAllocator<std::uint64_t>());
+
+    std::vector<Node*> nodes;
+    for (std::uint64_t i = 0; i < 10000; ++i) {
+        auto node = node_alloc.allocate(1);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(node) % alignof(Node), 0);
+        node->key = i;
+        nodes.push_back(node);
+    }
+    for (std::uint64_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_EQ(nodes[i]->key, i);
+    }
+    for (auto node: nodes) {
+        node_alloc.deallocate(node, 1);
+    }
+}
+
+TEST(slab, arena) {
+    yfast::utils::ArenaAllocator<Node> alloc;
+    auto copy = alloc;
+    for (auto i = 0; i < 10000; ++i) {
+        copy.allocate(1)->key = i;
+    }
+    alloc.release();
+    EXPECT_NE(alloc.allocate(1), nullptr);
+    EXPECT_TRUE(yfast::internal::ArenaAllocatorGeneric<decltype(alloc)>);
+    EXPECT_FALSE(yfast::internal::ArenaAllocatorGeneric<yfast::utils::SlabAllocator<Node>>);
+}